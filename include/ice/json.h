@@ -1,6 +1,17 @@
 #pragma once
+#include <ice/json/cbor.h>
+#include <ice/json/document.h>
+#include <ice/json/hash.h>
+#include <ice/json/input.h>
+#include <ice/json/keys.h>
 #include <ice/json/value.h>
 #include <ice/json/traits.h>
+#include <ice/json/lines.h>
+#include <ice/json/msgpack.h>
 #include <ice/json/parse.h>
+#include <ice/json/path.h>
+#include <ice/json/view.h>
+#include <ice/json/writer.h>
 #include <ice/json/traits/map.h>
 #include <ice/json/traits/date.h>
+#include <ice/json/traits/fields.h>
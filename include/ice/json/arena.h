@@ -0,0 +1,119 @@
+#pragma once
+#include <memory>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+
+// Monotonic memory arena. Deallocation is a no-op and all memory is released at once when the arena is cleared or
+// destroyed. Not thread safe.
+class arena {
+public:
+  // Creates an empty arena. Memory is reserved in blocks of at least the given size.
+  explicit arena(std::size_t block_size = 64 * 1024) noexcept;
+
+  arena(arena&& other) = delete;
+  arena(const arena& other) = delete;
+
+  ~arena();
+
+  arena& operator=(arena&& other) = delete;
+  arena& operator=(const arena& other) = delete;
+
+  // Returns a pointer to uninitialized memory with the given size and alignment.
+  void* allocate(std::size_t size, std::size_t alignment)
+  {
+    auto pos = (reinterpret_cast<std::uintptr_t>(pos_) + alignment - 1) & ~(alignment - 1);
+    if (!pos_ || pos + size > reinterpret_cast<std::uintptr_t>(end_)) {
+      return allocate_block(size, alignment);
+    }
+    pos_ = reinterpret_cast<char*>(pos + size);
+    return reinterpret_cast<void*>(pos);
+  }
+
+  // Releases all allocations. Reserved memory is kept for reuse in a single block.
+  void clear() noexcept;
+
+  // Returns the number of bytes reserved by the arena.
+  std::size_t capacity() const noexcept;
+
+private:
+  struct block {
+    block* next;
+    std::size_t size;
+  };
+
+  void* allocate_block(std::size_t size, std::size_t alignment);
+
+  block* head_ = nullptr;
+  char* pos_ = nullptr;
+  char* end_ = nullptr;
+  std::size_t block_size_;
+};
+
+// Allocator for json arrays and objects.
+// Uses the global allocator by default or the given arena. The arena is not propagated on copy or move assignment and
+// copies of containers use the global allocator, so that copying a value out of an arena always detaches it.
+template <typename T>
+class allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap = std::false_type;
+
+  allocator() noexcept = default;
+
+  allocator(json::arena* arena) noexcept : arena_(arena)
+  {}
+
+  template <typename U>
+  allocator(const allocator<U>& other) noexcept : arena_(other.arena())
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    if (arena_) {
+      return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    if (!arena_) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  }
+
+  allocator select_on_container_copy_construction() const noexcept
+  {
+    return {};
+  }
+
+  // Returns the arena or nullptr if the global allocator is used.
+  json::arena* arena() const noexcept
+  {
+    return arena_;
+  }
+
+private:
+  json::arena* arena_ = nullptr;
+};
+
+template <typename T, typename U>
+inline bool operator==(const allocator<T>& a, const allocator<U>& b) noexcept
+{
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const allocator<T>& a, const allocator<U>& b) noexcept
+{
+  return a.arena() != b.arena();
+}
+
+}  // namespace json
+}  // namespace ice
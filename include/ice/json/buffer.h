@@ -0,0 +1,101 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <cstddef>
+#include <cstring>
+
+namespace ice {
+namespace json {
+
+// Contiguous output buffer used by 'ice::json::format()'.
+// A default constructed buffer grows as needed and keeps all output. A buffer that wraps caller-provided memory passes
+// its contents to the flush function whenever it is full. Call 'flush()' to pass the remaining contents.
+// Usage: ice::json::buffer out; ice::json::format(out, root, false); send(out.data(), out.size());
+// Usage: char data[4096]; ice::json::buffer out(data, sizeof(data), send); ice::json::format(out, root); out.flush();
+class buffer {
+public:
+  using flush_function = std::function<void(const char* data, std::size_t size)>;
+
+  // Creates an empty growable buffer.
+  buffer() = default;
+
+  // Creates a buffer that writes into the given memory and passes it to the flush function when it is full.
+  // The memory must not be empty and must outlive the buffer.
+  buffer(char* data, std::size_t size, flush_function flush);
+
+  buffer(buffer&& other) = delete;
+  buffer(const buffer& other) = delete;
+
+  buffer& operator=(buffer&& other) = delete;
+  buffer& operator=(const buffer& other) = delete;
+
+  // Appends a character.
+  void append(char c)
+  {
+    if (pos_ == end_) {
+      overflow(1);
+    }
+    *pos_++ = c;
+  }
+
+  // Appends the given characters.
+  void append(const char* data, std::size_t size)
+  {
+    if (size > static_cast<std::size_t>(end_ - pos_) && !overflow(data, size)) {
+      return;
+    }
+    std::memcpy(pos_, data, size);
+    pos_ += size;
+  }
+
+  // Appends the given character 'count' times.
+  void append(std::size_t count, char c);
+
+  // Makes sure that at least 'size' characters can be appended without growing or flushing the buffer.
+  // Flushes a fixed buffer early if necessary. Does nothing if 'size' is larger than the fixed buffer.
+  void reserve(std::size_t size);
+
+  // Returns a pointer to the characters that have not been flushed yet.
+  const char* data() const noexcept
+  {
+    return begin_;
+  }
+
+  // Returns the number of characters that have not been flushed yet.
+  std::size_t size() const noexcept
+  {
+    return static_cast<std::size_t>(pos_ - begin_);
+  }
+
+  // Returns the number of characters that can be stored without growing or flushing the buffer.
+  std::size_t capacity() const noexcept
+  {
+    return static_cast<std::size_t>(end_ - begin_);
+  }
+
+  // Passes the contents to the flush function and clears the buffer. Does nothing for growable buffers.
+  void flush();
+
+  // Discards the contents without flushing them.
+  void clear() noexcept
+  {
+    pos_ = begin_;
+  }
+
+  // Returns the contents as a string and clears the buffer.
+  // Moves the storage of a growable buffer into the string without copying.
+  std::string release();
+
+private:
+  void overflow(std::size_t size);
+  bool overflow(const char* data, std::size_t size);
+
+  std::string storage_;  // growable buffer memory
+  flush_function flush_;
+  char* begin_ = nullptr;
+  char* pos_ = nullptr;
+  char* end_ = nullptr;
+};
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,29 @@
+#pragma once
+#include <ice/json/buffer.h>
+#include <ice/json/value.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <cstddef>
+
+namespace ice {
+namespace json {
+namespace cbor {
+
+// Encodes the given json value as CBOR (RFC 8949).
+// Integral numbers are encoded as integers and other numbers as single or double precision floats, whichever is
+// lossless. Strings are encoded as text strings and containers with definite lengths.
+std::string encode(const value& root);
+std::ostream& encode(std::ostream& os, const value& root);
+void encode(buffer& out, const value& root);
+
+// Decodes a single CBOR data item. Trailing data is ignored and streams are only read up to the end of the item.
+// Byte strings are decoded as strings, undefined as null and tags are ignored. Map keys must be text strings.
+// Throws 'ice::json::parse_error' on invalid, incomplete or unsupported input.
+value decode(std::istream& is);
+value decode(const std::string& data);
+value decode(const char* data, std::size_t size);
+
+}  // namespace cbor
+}  // namespace json
+}  // namespace ice
@@ -4,19 +4,18 @@
 namespace ice {
 namespace json {
 
+// Json value storage. Long strings, arrays and objects are stored out of line to keep json values small.
+// Short strings are stored in place of this union and the bytes that follow it (see 'ice::json::value::short_size').
+// Strings parsed by 'ice::json::document::parse(std::string&&)' refer to the characters in the document buffer.
 union data {
   json::null null;
   json::boolean boolean;
   json::number number;
-  json::string string;
-  json::array array;
-  json::object object;
-
-  data()
-  {}
-
-  ~data()
-  {}
+  json::string* string;
+  const char* chars;
+  json::array* array;
+  json::object* object;
+  json::numbers* numbers;
 };
 
 }  // namespace json
@@ -0,0 +1,64 @@
+#pragma once
+#include <ice/json/arena.h>
+#include <ice/json/value.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ice {
+namespace json {
+
+// Json document that allocates parsed strings, names, arrays and objects from a monotonic arena.
+// Clearing or destroying the document releases all arena memory at once. Short strings are stored in the json values
+// and only the characters of strings that do not fit into the 'std::string' small buffer use the global allocator.
+// Values moved out of the document keep using its arena and must not outlive it. Copies are detached.
+// Documents can also take ownership of the parsed text. Strings then refer to the text instead of being copied.
+// Usage: ice::json::document doc; for (const auto& text : requests) { handle(doc.parse(text)); }
+class document {
+public:
+  // Creates an empty document. Arena memory is reserved in blocks of at least the given size.
+  explicit document(std::size_t block_size = 64 * 1024);
+
+  document(document&& other) = delete;
+  document(const document& other) = delete;
+
+  document& operator=(document&& other) = delete;
+  document& operator=(const document& other) = delete;
+
+  // Parses the given text and replaces the document root.
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  value& parse(const std::string& text);
+  value& parse(const char* text, std::size_t size);
+
+  // Parses the given text in place, keeps it and replaces the document root.
+  // Escaped strings are decoded inside the text. Strings that are not short refer to the text and stay valid until the
+  // document is cleared, parses again or is destroyed. Use 'as<ice::string_view>()' to read them without a copy.
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  value& parse(std::string&& text);
+  value& parse(std::vector<char>&& text);
+
+  // Returns a reference to the document root.
+  value& root() noexcept;
+
+  // Returns a const reference to the document root.
+  const value& root() const noexcept;
+
+  // Returns an allocator that can be used to create arrays and objects in the document arena.
+  json::allocator<element<value>> get_allocator() noexcept;
+
+  // Resets the document root to 'null', releases the parsed text and keeps the arena memory for reuse.
+  void clear() noexcept;
+
+private:
+  value& parse_in_situ(char* text, std::size_t size);
+
+  json::arena arena_;
+  std::string text_;        // text passed to 'parse(std::string&&)'
+  std::vector<char> data_;  // text passed to 'parse(std::vector<char>&&)'
+  value root_;
+};
+
+std::ostream& operator<<(std::ostream& os, const document& doc);
+
+}  // namespace json
+}  // namespace ice
@@ -54,6 +54,13 @@ public:
     return oss.str();
   }
 
+  static type_error const_unboxed(std::size_t size)
+  {
+    std::ostringstream oss;
+    oss << "could not get const unboxed string of size " << size << " as string";
+    return oss.str();
+  }
+
   static type_error as(json::type type, json::type target)
   {
     std::ostringstream oss;
@@ -1,4 +1,5 @@
 #pragma once
+#include <ice/json/buffer.h>
 #include <ice/json/value.h>
 #include <ostream>
 #include <cstdint>
@@ -14,5 +15,9 @@ std::string format(const value& root, bool pretty = true);
 // When 'pretty' is true, additional spacing is added. 
 std::ostream& format(std::ostream& os, const value& root, bool pretty = true, std::size_t offset = 0);
 
+// Serializes the given json value into the buffer.
+// When 'pretty' is true, additional spacing is added. Fixed buffers are not flushed at the end.
+void format(buffer& out, const value& root, bool pretty = true, std::size_t offset = 0);
+
 }  // namespace json
 }  // namespace ice
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <ice/json/types.h>
+#include <ice/string_view.h>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+
+// Receives json parser events without creating a json value.
+// Every function returns false to stop parsing. The default implementations ignore the event and continue.
+// String views are only valid until the function returns.
+// Usage: ice::json::parse(text, handler);
+class handler {
+public:
+  virtual ~handler() = default;
+
+  // Called for a 'null' value.
+  virtual bool on_null()
+  {
+    return true;
+  }
+
+  // Called for a 'true' or 'false' value.
+  virtual bool on_boolean(boolean)
+  {
+    return true;
+  }
+
+  // Called for a number value.
+  virtual bool on_number(number)
+  {
+    return true;
+  }
+
+  // Called for an integer value that can not be represented by a double exactly, but fits into 64 bits.
+  // The default implementation reports the nearest double.
+  virtual bool on_integer(std::int64_t v)
+  {
+    return on_number(static_cast<number>(v));
+  }
+
+  // Called for a string value.
+  virtual bool on_string(ice::string_view)
+  {
+    return true;
+  }
+
+  // Called for an object key. The next event belongs to the element value.
+  virtual bool on_key(ice::string_view)
+  {
+    return true;
+  }
+
+  // Called for the opening '[' of an array.
+  virtual bool on_start_array()
+  {
+    return true;
+  }
+
+  // Called for the closing ']' of an array.
+  virtual bool on_end_array()
+  {
+    return true;
+  }
+
+  // Called for the opening '{' of an object.
+  virtual bool on_start_object()
+  {
+    return true;
+  }
+
+  // Called for the closing '}' of an object.
+  virtual bool on_end_object()
+  {
+    return true;
+  }
+};
+
+}  // namespace json
+}  // namespace ice
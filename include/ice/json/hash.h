@@ -0,0 +1,85 @@
+#pragma once
+#include <ice/json/value.h>
+#include <functional>
+#include <utility>
+#include <cstddef>
+
+namespace ice {
+namespace json {
+
+// Returns a hash of the json value content, which is the same for values that compare equal.
+// Arrays stored as 'ice::json::numbers' have the same hash as regular arrays with the same numbers.
+// When 'canonical' is true, the order of object elements does not change the hash, so that objects that only differ
+// in their element order have the same hash.
+std::size_t hash(const value& v, bool canonical = false);
+
+// Returns true if the json values are equal. When 'canonical' is true, objects that only differ in their element order
+// are equal too, which matches the canonical hash.
+bool equal(const value& a, const value& b, bool canonical = false);
+
+// Immutable json value with a precomputed content hash (see 'ice::json::hash()').
+// Comparisons check the hashes first, so that unequal documents usually compare in constant time. This makes large
+// documents cheap keys for hash tables and caches.
+// Usage: std::unordered_map<ice::json::hashed, response> cache; cache.emplace(ice::json::hashed(request), r);
+class hashed {
+public:
+  // Stores the json value and computes its hash.
+  explicit hashed(json::value v, bool canonical = false) :
+    value_(std::move(v)), hash_(json::hash(value_, canonical)), canonical_(canonical)
+  {}
+
+  // Returns the json value.
+  const json::value& get() const noexcept
+  {
+    return value_;
+  }
+
+  // Returns the precomputed hash.
+  std::size_t hash() const noexcept
+  {
+    return hash_;
+  }
+
+  // Returns true if the hash and comparisons ignore the order of object elements.
+  bool canonical() const noexcept
+  {
+    return canonical_;
+  }
+
+private:
+  json::value value_;
+  std::size_t hash_;
+  bool canonical_;
+};
+
+// Compares the hashes and then the values (see 'ice::json::equal()').
+// Canonical and non-canonical values are never equal, because their hashes cannot be compared.
+bool operator==(const hashed& a, const hashed& b);
+
+inline bool operator!=(const hashed& a, const hashed& b)
+{
+  return !(a == b);
+}
+
+}  // namespace json
+}  // namespace ice
+
+namespace std {
+
+template <>
+struct hash<ice::json::value> {
+  size_t operator()(const ice::json::value& v) const
+  {
+    return ice::json::hash(v);
+  }
+};
+
+template <>
+struct hash<ice::json::hashed> {
+  size_t operator()(const ice::json::hashed& v) const noexcept
+  {
+    return v.hash();
+  }
+};
+
+}  // namespace std
@@ -0,0 +1,141 @@
+#pragma once
+#include <ice/json/value.h>
+#include <ice/string_view.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+namespace ice {
+namespace json {
+
+class input;
+
+namespace detail {
+
+// Checks if 'ice::json_traits<T>' implements 'static T read(ice::json::input& in)'.
+template <typename T, typename = void>
+struct has_read : std::false_type {};
+
+template <typename T>
+struct has_read<T, decltype(void(json_traits<T>::read(std::declval<input&>())))> : std::true_type {};
+
+}  // namespace detail
+
+// Reads a json value from a contiguous buffer token by token without creating a json value.
+// Used by 'ice::json_traits<T>::read()' to deserialize types directly from json text. Arrays are read with
+// 'start_array()' and 'next_element()', objects with 'start_object()' and 'next_key()'. Every element value must be
+// read or skipped before the next call to 'next_element()' or 'next_key()'.
+// Trailing data after the root value is ignored, like in 'ice::json::parse()'.
+// The buffer must outlive the input.
+// Usage: in.start_array(); while (in.next_element()) { ids.push_back(in.read<int>()); }
+class input {
+public:
+  // Creates an input for the json value in the given buffer.
+  input(const char* data, std::size_t size);
+
+  // Creates an input for the json value in the given string. The string must outlive the input.
+  explicit input(const std::string& text);
+
+  // Creates an input for the json value at 'data' inside a larger buffer. Error positions are relative to 'origin'.
+  input(const char* origin, const char* data, std::size_t size);
+
+  input(input&& other) = delete;
+  input(const input& other) = delete;
+
+  input& operator=(input&& other) = delete;
+  input& operator=(const input& other) = delete;
+
+  // Returns the json value type of the next value based on its first character.
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  json::type type();
+
+  // Reads the next value as the given type.
+  // Uses 'ice::json_traits<T>::read()' if available. Otherwise the value is read with 'read_value()' and converted
+  // with 'ice::json::value::as()'.
+  template <typename T>
+  T read()
+  {
+    return read_traits<T>(detail::has_read<T>());
+  }
+
+  // Reads the next value into a json value. Only arrays and objects allocate memory for their elements.
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  value read_value();
+
+  // Reads the next string value. The result is valid until the next call.
+  // Throws 'ice::json::type_error' if the next value is not a string.
+  ice::string_view read_string();
+
+  // Skips the next value. Skipped values are checked for syntax errors.
+  void skip();
+
+  // Reads the opening '[' of an array.
+  // Throws 'ice::json::type_error' if the next value is not an array.
+  void start_array();
+
+  // Returns true if the current array has another element, which must be read next.
+  // Returns false after reading the closing ']'.
+  bool next_element();
+
+  // Reads the opening '{' of an object.
+  // Throws 'ice::json::type_error' if the next value is not an object.
+  void start_object();
+
+  // Reads the next object key and the following ':' and returns true. The key is valid until the next call.
+  // Returns false after reading the closing '}'.
+  bool next_key(ice::string_view& key);
+
+  // Creates a parse error with the line and column of the current read position.
+  parse_error error(const char* message) const;
+
+private:
+  template <typename T>
+  T read_traits(std::true_type)
+  {
+    return json_traits<T>::read(*this);
+  }
+
+  template <typename T>
+  T read_traits(std::false_type)
+  {
+    return read_value().as<T>();
+  }
+
+  void skip_space();
+  bool next(char close, const char* message);
+
+  const char* origin_;  // start of the buffer for error positions
+  const char* it_;      // current read position
+  const char* end_;     // end of the buffer
+  std::string buffer_;  // decoded strings with escape sequences
+  bool first_ = true;   // no element of the current array or object was read yet
+};
+
+template <>
+inline value input::read<value>()
+{
+  return read_value();
+}
+
+// Deserializes the json text directly into the given type (see 'ice::json::input::read()').
+// Arrays, objects and strings are only stored in the result, so no intermediate json value is created for types
+// with 'ice::json_traits<T>::read()' implementations.
+// Throws 'ice::json::parse_error' on invalid or incomplete input.
+// Usage: auto config = ice::json::read<std::map<std::string, std::vector<int>>>(text);
+template <typename T>
+inline T read(const char* data, std::size_t size)
+{
+  input in(data, size);
+  return in.read<T>();
+}
+
+template <typename T>
+inline T read(const std::string& text)
+{
+  input in(text);
+  return in.read<T>();
+}
+
+}  // namespace json
+}  // namespace ice
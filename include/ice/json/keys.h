@@ -0,0 +1,56 @@
+#pragma once
+#include <ice/json/types.h>
+#include <ice/string_view.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+namespace ice {
+namespace json {
+
+// Table of interned object element names that can be shared by many parsed json values.
+// Each distinct name is stored once and parsed objects only keep a pointer to it, so that names repeated in many
+// objects are not allocated again. Pass the table to the parser with 'ice::json::parse_options::keys' or
+// 'ice::json::line_options::keys'. Lookups are lock-free and new names are added under a mutex, so that parser threads
+// can share a table. Once the table holds 'capacity' names, other names are allocated per element as usual.
+// The table must outlive all values that use its names. Copies of such values own their names.
+// Usage: ice::json::keys keys; ice::json::parse_options options; options.keys = &keys; parse(text, options);
+class keys {
+public:
+  // Creates an empty table for up to 'capacity' names.
+  explicit keys(std::size_t capacity = 4096);
+
+  keys(keys&& other) = delete;
+  keys(const keys& other) = delete;
+
+  keys& operator=(keys&& other) = delete;
+  keys& operator=(const keys& other) = delete;
+
+  ~keys();
+
+  // Returns a name that shares the interned string. Returns an owned name if the table is full.
+  json::name intern(ice::string_view name);
+
+  // Returns the number of interned names.
+  std::size_t size() const;
+
+  // Returns the maximum number of interned names.
+  std::size_t capacity() const noexcept
+  {
+    return capacity_;
+  }
+
+private:
+  struct entry;
+
+  std::size_t capacity_;                          // maximum number of entries
+  std::size_t mask_;                              // number of slots - 1 (power of two)
+  std::unique_ptr<std::atomic<entry*>[]> slots_;  // open addressing hash table with linear probing
+  std::vector<std::unique_ptr<entry>> entries_;   // interned names in insertion order
+  mutable std::mutex mutex_;                      // serializes insertions
+};
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,46 @@
+#pragma once
+#include <ice/json/buffer.h>
+#include <ice/json/value.h>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace ice {
+namespace json {
+
+// Options for reading and writing newline-delimited json (json lines).
+struct line_options {
+  // Number of threads that parse or serialize lines. Uses the number of hardware threads if 0.
+  // A single thread parses on the calling thread without starting worker threads.
+  std::size_t threads = 0;
+
+  // Approximate size of the chunks that are parsed by a single thread. Chunks are split at line boundaries.
+  std::size_t chunk_size = 1024 * 1024;
+
+  // Passes values to the callback in input order if true or in the order the chunks are parsed if false.
+  bool ordered = true;
+
+  // Interns object element names of parsed lines in the given table if it is not null (see 'ice::json::keys').
+  json::keys* keys = nullptr;
+};
+
+// Receives a parsed json line. Called on the calling thread only.
+using line_function = std::function<void(value&& v)>;
+
+// Parses newline-delimited json and passes each value to the callback.
+// Empty lines are skipped and lines may end with "\r\n". Every other line must contain exactly one json value.
+// Throws 'ice::json::parse_error' for the first invalid line. Values of later lines may have been passed to the
+// callback already if 'ordered' is false. Exceptions thrown by the callback stop reading and are passed on.
+// Usage: ice::json::read_lines(std::cin, [&](ice::json::value&& event) { replay(event); });
+void read_lines(const char* data, std::size_t size, const line_function& callback, const line_options& options = {});
+void read_lines(const std::string& text, const line_function& callback, const line_options& options = {});
+void read_lines(std::istream& is, const line_function& callback, const line_options& options = {});
+
+// Serializes the values as newline-delimited json into the buffer, one compact value per line.
+// Large batches are serialized on 'options.threads' threads and appended to the buffer in order.
+void format_lines(buffer& out, const std::vector<value>& values, const line_options& options = {});
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,29 @@
+#pragma once
+#include <ice/json/buffer.h>
+#include <ice/json/value.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <cstddef>
+
+namespace ice {
+namespace json {
+namespace msgpack {
+
+// Encodes the given json value as MessagePack.
+// Integral numbers are encoded as integers and other numbers as float 32 or float 64, whichever is lossless.
+// Each value uses the smallest format that can store it.
+std::string encode(const value& root);
+std::ostream& encode(std::ostream& os, const value& root);
+void encode(buffer& out, const value& root);
+
+// Decodes a single MessagePack object. Trailing data is ignored and streams are only read up to the end of the object.
+// Binary data is decoded as strings. Map keys must be strings.
+// Throws 'ice::json::parse_error' on invalid, incomplete or unsupported input (e.g. extension types).
+value decode(std::istream& is);
+value decode(const std::string& data);
+value decode(const char* data, std::size_t size);
+
+}  // namespace msgpack
+}  // namespace json
+}  // namespace ice
@@ -1,4 +1,5 @@
 #pragma once
+#include <ice/json/handler.h>
 #include <ice/json/value.h>
 #include <istream>
 #include <string>
@@ -6,9 +7,33 @@
 namespace ice {
 namespace json {
 
+// Options for 'ice::json::parse()'.
+struct parse_options {
+  // Number of threads that parse the elements of a large root array. Uses the number of hardware threads if 0.
+  std::size_t threads = 1;
+
+  // Minimum input size in bytes for parsing a root array on multiple threads.
+  std::size_t parallel_size = 1024 * 1024;
+
+  // Interns object element names in the given table if it is not null (see 'ice::json::keys').
+  json::keys* keys = nullptr;
+};
+
 value parse(std::istream& is);
 value parse(const std::string& text);
 value parse(const char* src, std::size_t size);
 
+// Parses the given text. If the root value is an array, a first pass finds element boundaries and the elements are
+// parsed on multiple threads. The result and parse errors are the same as for a single thread.
+// Object element names are interned in 'options.keys', which must outlive the result.
+value parse(const std::string& text, const parse_options& options);
+value parse(const char* src, std::size_t size, const parse_options& options);
+
+// Parses a json value and reports it to the handler without creating a json value.
+// Returns false if the handler stopped parsing before the end of the value.
+// Throws 'ice::json::parse_error' on invalid or incomplete input.
+bool parse(const std::string& text, handler& handler);
+bool parse(const char* src, std::size_t size, handler& handler);
+
 }  // namespace json
 }  // namespace ice
\ No newline at end of file
@@ -54,6 +54,13 @@ public:
   };
 
   bool put(char c);
+
+  // Parses the given chunk of input until a value is complete. Returns true if a value is complete.
+  // Stores the number of bytes consumed in 'consumed'. Remaining bytes belong to the next value and can be passed to
+  // this function again after the current value was retrieved with 'get()' and the parser was reset with 'clear()'.
+  // The chunk may end anywhere, including in the middle of a string, number or escape sequence.
+  bool put(const char* data, std::size_t size, std::size_t& consumed);
+
   bool complete() const;
 
   value& get();
@@ -65,6 +72,7 @@ public:
   state current_state() const;
 
 private:
+  std::size_t put_run(const char* begin, const char* end);
   void append_inner_value();
   void assign_inner_value();
 
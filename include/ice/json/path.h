@@ -0,0 +1,75 @@
+#pragma once
+#include <ice/json/value.h>
+#include <ice/json/view.h>
+#include <ice/string_view.h>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+
+// Compiled json pointer (RFC 6901) or path expression that selects values from a json value or a json view.
+// Json pointers are empty or start with '/': "/items/0/name", "/a~1b" (key "a/b"), "/m~0n" (key "m~n").
+// Pointer tokens that are array indices select array elements and object elements with the same key.
+// Path expressions start with '$' and support the following steps:
+//   .name or ['name']  object element
+//   [2] or [-1]        array element, negative indices count from the end
+//   .* or [*]          all array or object elements
+//   [1:3] or [:-1]     array elements in a slice, the start is inclusive and the end is exclusive
+// Usage: static const ice::json::path route("/meta/route"); if (auto v = route.find(root)) { forward(*v); }
+class path {
+public:
+  // Compiles the given json pointer or path expression.
+  // Throws 'ice::json::parse_error' if the expression is invalid.
+  explicit path(ice::string_view expression);
+
+  // Returns the first selected value or nullptr.
+  value* find(value& root) const;
+  const value* find(const value& root) const;
+
+  // Returns a view of the first selected value or an empty view.
+  view find(const view& root) const;
+
+  // Returns all selected values in document order.
+  std::vector<value*> select(value& root) const;
+  std::vector<const value*> select(const value& root) const;
+  std::vector<view> select(const view& root) const;
+
+  // Returns the expression the path was compiled from.
+  const std::string& expression() const noexcept
+  {
+    return expression_;
+  }
+
+private:
+  struct step {
+    enum kind_type : std::uint8_t { name, index, all, slice };
+
+    kind_type kind = name;
+    bool has_begin = false;  // the slice start is set
+    bool has_end = false;    // the slice end is set
+    std::string key;         // object element name
+    std::int64_t begin = 0;  // array index or slice start, -1 for names that are not array indices
+    std::int64_t end = 0;    // slice end
+
+    bool range(std::size_t size, std::size_t& first, std::size_t& last) const;
+    bool needs_size() const noexcept;
+  };
+
+  void compile_pointer();
+  void compile_path();
+
+  template <typename Value, typename Visitor>
+  static bool select(const step* it, const step* end, Value& node, Visitor& visitor);
+
+  template <typename Visitor>
+  static bool select(const step* it, const step* end, const view& node, Visitor& visitor);
+
+  std::string expression_;
+  std::vector<step> steps_;
+};
+
+}  // namespace json
+}  // namespace ice
@@ -1,8 +1,12 @@
 #pragma once
+#include <ice/json/input.h>
 #include <ice/json/value.h>
 #include <ice/utf8.h>
 #include <map>
 #include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 
@@ -16,7 +20,13 @@ struct json_traits {
   {
     auto number_v = static_cast<json::number>(v);
     if (v != static_cast<T>(number_v)) {
-      throw json::bad_cast::numeric<T>(v);
+      // Keep integers that can not be represented by a double exactly.
+      auto integer_v = static_cast<std::int64_t>(v);
+      if (v != static_cast<T>(integer_v) || (v < 0) != (integer_v < 0)) {
+        throw json::bad_cast::numeric<T>(v);
+      }
+      self.reset(integer_v);
+      return;
     }
     self = number_v;
   }
@@ -31,6 +41,14 @@ struct json_traits {
   static T as(const json::value& self, json::numeric<T>* dummy = nullptr)
   {
     auto number_v = self.as<json::number>();
+    if (self.has_integer()) {
+      auto integer_v = self.as_integer();
+      auto v = static_cast<T>(integer_v);
+      if (integer_v != static_cast<std::int64_t>(v) || (v < 0) != (integer_v < 0)) {
+        throw json::bad_cast::numeric<T>(number_v);
+      }
+      return v;
+    }
     auto v = static_cast<T>(number_v);
     if (number_v != static_cast<json::number>(v)) {
       throw json::bad_cast::numeric<T>(number_v);
@@ -145,11 +163,13 @@ struct json_traits<json::number> {
   }
 
   // Used by 'ice::json::value::data()'. Should not be implemented for non-native json value types.
+  // The number may be modified through the returned reference, so an exact integer is replaced by the nearest double.
   static json::number& data(json::value& self)
   {
     if (self.type_ != json::type::number) {
       throw json::type_error::data(self.type_, json::type::number);
     }
+    self.flags_ &= ~json::value::integer_flag;
     return self.data_.number;
   }
 
@@ -191,21 +211,29 @@ struct json_traits<json::string> {
   }
 
   // Used by 'ice::json::value::data()'. Should not be implemented for non-native json value types.
+  // Short strings and views are moved to the heap, so that they can be modified through the returned reference.
   static json::string& data(json::value& self)
   {
     if (self.type_ != json::type::string) {
       throw json::type_error::data(self.type_, json::type::string);
     }
-    return self.data_.string;
+    if (self.flags_ & (json::value::short_flag | json::value::view_flag)) {
+      return self.unshort();
+    }
+    return *self.data_.string;
   }
 
   // Used by 'const ice::json::value::data() const'. Should not be implemented for non-native json value types.
+  // Short strings and views have no 'std::string' to refer to. Use 'as<ice::string_view>()' instead.
   static const json::string& data(const json::value& self)
   {
     if (self.type_ != json::type::string) {
       throw json::type_error::const_data(self.type_, json::type::string);
     }
-    return self.data_.string;
+    if (self.flags_ & (json::value::short_flag | json::value::view_flag)) {
+      throw json::type_error::const_unboxed(self.text().size());
+    }
+    return *self.data_.string;
   }
 
   // Used by 'ice::json::value::as()'.
@@ -213,6 +241,51 @@ struct json_traits<json::string> {
   {
     return self.as_string();
   }
+
+  // Used by 'ice::json::value::take()'.
+  static json::string take(json::value& self)
+  {
+    if (self.type_ == json::type::string && !(self.flags_ & (json::value::short_flag | json::value::view_flag))) {
+      return std::move(*self.data_.string);
+    }
+    return self.as_string();
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static json::string read(json::input& in)
+  {
+    if (in.type() == json::type::string) {
+      auto v = in.read_string();
+      return json::string(v.data(), v.size());
+    }
+    return as(in.read_value());
+  }
+};
+
+// Provides access to json strings without copies.
+// The returned view is valid until the json value is modified or destroyed.
+template <>
+struct json_traits<ice::string_view> {
+  // Used by the 'ice::json::value' constructor and assignment operator.
+  static void assign(json::value& self, ice::string_view v)
+  {
+    self.reset(json::string(v.data(), v.size()));
+  }
+
+  // Used by 'ice::json::value::is()'.
+  static bool is(const json::value& self)
+  {
+    return self.type_ == json::type::string;
+  }
+
+  // Used by 'ice::json::value::as()'.
+  static ice::string_view as(const json::value& self)
+  {
+    if (self.type_ != json::type::string) {
+      throw json::type_error::as(self.type_, json::type::string);
+    }
+    return self.text();
+  }
 };
 
 // Makes it possible to check for the 'array' json value type.
@@ -242,7 +315,7 @@ struct json_traits<json::array> {
     if (self.type_ != json::type::array) {
       throw json::type_error::data(self.type_, json::type::array);
     }
-    return self.data_.array;
+    return self.elements();
   }
 
   // Used by 'const ice::json::value::data() const'. Should not be implemented for non-native json value types.
@@ -251,7 +324,7 @@ struct json_traits<json::array> {
     if (self.type_ != json::type::array) {
       throw json::type_error::const_data(self.type_, json::type::array);
     }
-    return self.data_.array;
+    return self.elements();
   }
 
   // Used by 'ice::json::value::as()'.
@@ -259,6 +332,93 @@ struct json_traits<json::array> {
   {
     return data(self);
   }
+
+  // Used by 'ice::json::value::take()'.
+  static json::array take(json::value& self)
+  {
+    return std::move(data(self));
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static json::array read(json::input& in)
+  {
+    auto v = in.read_value();
+    return std::move(data(v));
+  }
+};
+
+// Makes it possible to access arrays that are stored as 'ice::json::numbers'.
+template <>
+struct json_traits<json::numbers> {
+  // Used by the 'ice::json::value' constructor and assignment operator.
+  static void assign(json::value& self, json::numbers&& v)
+  {
+    self.reset(std::move(v));
+  }
+
+  // Used by the 'ice::json::value' constructor and assignment operator.
+  static void assign(json::value& self, const json::numbers& v)
+  {
+    self.reset(v);
+  }
+
+  // Used by 'ice::json::value::is()'.
+  static bool is(const json::value& self)
+  {
+    return self.type_ == json::type::array && (self.flags_ & json::value::packed_flag);
+  }
+
+  // Used by 'ice::json::value::data()'. Should not be implemented for non-native json value types.
+  static json::numbers& data(json::value& self)
+  {
+    if (!is(self)) {
+      throw json::type_error::data(self.type_, json::type::array);
+    }
+    self.data_.numbers->release();
+    return *self.data_.numbers;
+  }
+
+  // Used by 'const ice::json::value::data() const'. Should not be implemented for non-native json value types.
+  static const json::numbers& data(const json::value& self)
+  {
+    if (!is(self)) {
+      throw json::type_error::const_data(self.type_, json::type::array);
+    }
+    return *self.data_.numbers;
+  }
+
+  // Used by 'ice::json::value::as()'. Converts regular arrays of numbers, too.
+  static json::numbers as(const json::value& self)
+  {
+    if (is(self)) {
+      return *self.data_.numbers;
+    }
+    json::numbers v;
+    for (const auto& e : self.data<json::array>()) {
+      v.push_back(e.value.as<json::number>());
+    }
+    return v;
+  }
+
+  // Used by 'ice::json::value::take()'.
+  static json::numbers take(json::value& self)
+  {
+    if (is(self)) {
+      return std::move(*self.data_.numbers);
+    }
+    return as(self);
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static json::numbers read(json::input& in)
+  {
+    json::numbers v;
+    in.start_array();
+    while (in.next_element()) {
+      v.push_back(in.read<json::number>());
+    }
+    return v;
+  }
 };
 
 // Makes it possible to check for the 'object' json value type.
@@ -288,7 +448,7 @@ struct json_traits<json::object> {
     if (self.type_ != json::type::object) {
       throw json::type_error::data(self.type_, json::type::object);
     }
-    return self.data_.object;
+    return *self.data_.object;
   }
 
   // Used by 'const ice::json::value::data() const'. Should not be implemented for non-native json value types.
@@ -297,7 +457,7 @@ struct json_traits<json::object> {
     if (self.type_ != json::type::object) {
       throw json::type_error::const_data(self.type_, json::type::object);
     }
-    return self.data_.object;
+    return *self.data_.object;
   }
 
   // Used by 'ice::json::value::as()'.
@@ -305,6 +465,19 @@ struct json_traits<json::object> {
   {
     return data(self);
   }
+
+  // Used by 'ice::json::value::take()'.
+  static json::object take(json::value& self)
+  {
+    return std::move(data(self));
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static json::object read(json::input& in)
+  {
+    auto v = in.read_value();
+    return std::move(data(v));
+  }
 };
 
 // Adds support for 'float' (de)serialization.
@@ -345,24 +518,48 @@ struct json_traits<const char*> {
   }
 };
 
+namespace detail {
+
+// Checks if a 'std::vector<T>' can be stored as 'ice::json::numbers'.
+template <typename T>
+struct is_packable : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value> {};
+
+// Converts an arithmetic value to a number for 'ice::json::numbers'.
+// Returns false for integers beyond 2^53, which 'ice::json::value' keeps exact as an integer.
+template <typename T>
+inline bool to_packed(T v, json::number& n) noexcept
+{
+  n = static_cast<json::number>(v);
+  return std::is_floating_point<T>::value || (n < 9007199254740992.0 && n > -9007199254740992.0);
+}
+
+}  // namespace detail
+
 // Adds support for 'std::vector<T>' (de)serialization.
+// Vectors of 'ice::json::numbers::threshold' or more arithmetic values are stored as 'ice::json::numbers'.
 template <typename T>
 struct json_traits<std::vector<T>> {
   // Used by the 'ice::json::value' constructor and assignment operator.
   static void assign(json::value& self, std::vector<T>&& v)
   {
+    if (pack(self, v, detail::is_packable<T>())) {
+      return;
+    }
     self.reset(json::type::array);
     for (auto& e : v) {
-      self.append(std::move(e));
+      self.append(json::value(std::move(e)));
     }
   }
 
   // Used by the 'ice::json::value' constructor and assignment operator.
   static void assign(json::value& self, const std::vector<T>& v)
   {
+    if (pack(self, v, detail::is_packable<T>())) {
+      return;
+    }
     self.reset(json::type::array);
     for (auto& e : v) {
-      self.append(e);
+      self.append(json::value(e));
     }
   }
 
@@ -376,20 +573,83 @@ struct json_traits<std::vector<T>> {
   static std::vector<T> as(const json::value& self)
   {
     std::vector<T> v;
-    if (self.type() == json::type::array) {
+    if (self.is<json::numbers>()) {
+      const auto& numbers = self.data<json::numbers>();
+      v.reserve(numbers.size());
+      for (auto n : numbers) {
+        v.push_back(json::value(n).as<T>());
+      }
+    } else if (self.type() == json::type::array) {
       for (const auto& e : self) {
         v.push_back(e.value.as<T>());
       }
     }
     return v;
   }
+
+  // Used by 'ice::json::value::take()'.
+  static std::vector<T> take(json::value& self)
+  {
+    if (self.is<json::numbers>()) {
+      return as(self);
+    }
+    std::vector<T> v;
+    if (self.type() == json::type::array) {
+      v.reserve(self.size());
+      for (auto& e : self) {
+        v.push_back(e.value.take<T>());
+      }
+    }
+    return v;
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static std::vector<T> read(json::input& in)
+  {
+    std::vector<T> v;
+    if (in.type() != json::type::array) {
+      in.skip();
+      return v;
+    }
+    in.start_array();
+    while (in.next_element()) {
+      v.push_back(in.read<T>());
+    }
+    return v;
+  }
+
+private:
+  static bool pack(json::value& self, const std::vector<T>& v, std::true_type)
+  {
+    if (v.size() < json::numbers::threshold) {
+      return false;
+    }
+    json::numbers numbers;
+    numbers.resize(v.size());
+    for (std::size_t i = 0; i < v.size(); i++) {
+      if (!detail::to_packed(v[i], numbers[i])) {
+        return false;
+      }
+    }
+    self.reset(std::move(numbers));
+    return true;
+  }
+
+  static bool pack(json::value&, const std::vector<T>&, std::false_type)
+  {
+    return false;
+  }
 };
 
-// Adds support for 'std::map<std::string, T>' (de)serialization.
-template <typename T>
-struct json_traits<std::map<std::string, T>> {
+namespace detail {
+
+// Implements 'ice::json_traits' for maps with 'std::string' keys.
+template <typename Map>
+struct string_map_traits {
+  using mapped_type = typename Map::mapped_type;
+
   // Used by the 'ice::json::value' constructor and assignment operator.
-  static void assign(json::value& self, std::map<std::string, T>&& v)
+  static void assign(json::value& self, Map&& v)
   {
     self.reset(json::type::object);
     for (auto& e : v) {
@@ -398,7 +658,7 @@ struct json_traits<std::map<std::string, T>> {
   }
 
   // Used by the 'ice::json::value' constructor and assignment operator.
-  static void assign(json::value& self, const std::map<std::string, T>& v)
+  static void assign(json::value& self, const Map& v)
   {
     self.reset(json::type::object);
     for (auto& e : v) {
@@ -413,13 +673,13 @@ struct json_traits<std::map<std::string, T>> {
   }
 
   // Used by 'ice::json::value::as()'.
-  static std::map<std::string, T> as(const json::value& self)
+  static Map as(const json::value& self)
   {
-    std::map<std::string, T> v;
+    Map v;
     auto type = self.type();
     if (type == json::type::object) {
       for (const auto& e : self) {
-        v[e.name.value()] = e.value.as<T>();
+        v[e.name.value()] = e.value.as<mapped_type>();
       }
     } else if (type == json::type::array) {
       // Uses the vector index as an object key.
@@ -427,15 +687,73 @@ struct json_traits<std::map<std::string, T>> {
       std::ostringstream oss;
       for (const auto& e : self) {
         oss << index++;
-        v[oss.str()] = e.value.as<T>();
+        v[oss.str()] = e.value.as<mapped_type>();
         oss.str(std::string());
         oss.clear();
       }
     }
     return v;
   }
+
+  // Used by 'ice::json::value::take()'.
+  // Element names are moved into the map, so the json value is reset afterwards.
+  static Map take(json::value& self)
+  {
+    Map v;
+    auto type = self.type();
+    if (type == json::type::object) {
+      for (auto& e : self) {
+        v[e.name.take()] = e.value.template take<mapped_type>();
+      }
+      self.reset();
+    } else if (type == json::type::array) {
+      // Uses the vector index as an object key.
+      std::size_t index = 0;
+      for (auto& e : self) {
+        v[std::to_string(index++)] = e.value.template take<mapped_type>();
+      }
+    }
+    return v;
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static Map read(json::input& in)
+  {
+    Map v;
+    auto type = in.type();
+    if (type == json::type::object) {
+      in.start_object();
+      ice::string_view key;
+      while (in.next_key(key)) {
+        // The key is only valid until the value is read.
+        auto& e = v[std::string(key.data(), key.size())];
+        e = in.read<mapped_type>();
+      }
+    } else if (type == json::type::array) {
+      // Uses the vector index as an object key.
+      std::size_t index = 0;
+      in.start_array();
+      while (in.next_element()) {
+        v[std::to_string(index++)] = in.read<mapped_type>();
+      }
+    } else {
+      in.skip();
+    }
+    return v;
+  }
 };
 
+}  // namespace detail
+
+// Adds support for 'std::map<std::string, T>' (de)serialization.
+template <typename T>
+struct json_traits<std::map<std::string, T>> : detail::string_map_traits<std::map<std::string, T>> {};
+
+// Adds support for 'std::unordered_map<std::string, T>' (de)serialization.
+template <typename T>
+struct json_traits<std::unordered_map<std::string, T>> :
+  detail::string_map_traits<std::unordered_map<std::string, T>> {};
+
 // Adds support for 'ice::optional<T>' (de)serialization.
 template <typename T>
 struct json_traits<ice::optional<T>> {
@@ -473,6 +791,25 @@ struct json_traits<ice::optional<T>> {
     }
     return self.as<T>();
   }
+
+  // Used by 'ice::json::value::take()'.
+  static ice::optional<T> take(json::value& self)
+  {
+    if (self.type() == json::type::null) {
+      return ice::optional<T>();
+    }
+    return self.take<T>();
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static ice::optional<T> read(json::input& in)
+  {
+    if (in.type() == json::type::null) {
+      in.skip();
+      return ice::optional<T>();
+    }
+    return in.read<T>();
+  }
 };
 
 }  // namespace ice
\ No newline at end of file
@@ -0,0 +1,240 @@
+#pragma once
+#include <ice/json/input.h>
+#include <ice/json/traits.h>
+#include <ice/json/value.h>
+#include <ice/string_view.h>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Generates 'ice::json_traits' for a struct from a list of its fields.
+// Fields are stored as object elements with the field name as key. Conversion to the struct ignores unknown keys and
+// keeps the default value of missing fields. Other json value types are converted to a default constructed struct.
+// Keys are matched by length and a hash that is computed at compile time, so each key is hashed once and only compared
+// to field names with the same length and hash. Field values are converted with 'ice::json_traits' of their types.
+// Must be used in the global namespace with a default constructible type and at most 32 fields.
+// Usage: ICE_JSON_FIELDS(app::order, id, price, qty)
+#define ICE_JSON_FIELDS(type, ...)                                                                                    \
+  namespace ice {                                                                                                    \
+  template <>                                                                                                        \
+  struct json_traits<type> : json::detail::field_traits<type, json_traits<type>> {                                   \
+    static constexpr auto fields() noexcept                                                                          \
+    {                                                                                                                \
+      return std::make_tuple(ICE_JSON_F_X(ICE_JSON_F_FOR_EACH(type, __VA_ARGS__)));                                \
+    }                                                                                                                \
+  };                                                                                                                 \
+  }
+
+namespace ice {
+namespace json {
+namespace detail {
+
+// Struct field description created by 'ICE_JSON_FIELDS'.
+template <typename T, typename M>
+struct field {
+  using member_type = M;
+
+  const char* name;
+  std::size_t size;
+  std::uint32_t hash;
+  M T::*member;
+};
+
+template <typename T, typename M, std::size_t N>
+constexpr field<T, M> make_field(const char (&name)[N], M T::*member) noexcept
+{
+  return { name, N - 1, name_hash(name, N - 1), member };
+}
+
+// Calls the function with the field if it matches the given key.
+template <typename Field, typename Function>
+inline bool match_field(const Field& field, const char* key, std::size_t size, std::uint32_t hash, Function& function)
+{
+  if (field.size != size || field.hash != hash || std::memcmp(field.name, key, size) != 0) {
+    return false;
+  }
+  function(field);
+  return true;
+}
+
+// Calls the function with the field that matches the given key. Returns false if no field matches.
+template <typename Fields, typename Function, std::size_t... I>
+inline bool find_field(const Fields& fields, ice::string_view key, Function&& function, std::index_sequence<I...>)
+{
+  auto hash = name_hash(key.data(), key.size());
+  auto found = false;
+  (void)std::initializer_list<bool>{ (found = found || match_field(std::get<I>(fields), key.data(), key.size(), hash,
+    function))... };
+  return found;
+}
+
+// Calls the function with every field.
+template <typename Fields, typename Function, std::size_t... I>
+inline void for_each_field(const Fields& fields, Function&& function, std::index_sequence<I...>)
+{
+  (void)std::initializer_list<int>{ (function(std::get<I>(fields)), 0)... };
+}
+
+// Implements 'ice::json_traits' for structs with fields described by 'Traits::fields()' (see 'ICE_JSON_FIELDS').
+template <typename T, typename Traits>
+struct field_traits {
+  // Used by the 'ice::json::value' constructor and assignment operator.
+  static void assign(json::value& self, T&& v)
+  {
+    json::object o;
+    o.reserve(count());
+    for_each_field(fields(), [&](const auto& field) {
+      using member_type = typename std::decay_t<decltype(field)>::member_type;
+      json::value e;
+      json_traits<member_type>::assign(e, std::move(v.*field.member));
+      o.append(json::name(std::string(field.name, field.size)), std::move(e));
+    }, sequence());
+    self.reset(std::move(o));
+  }
+
+  // Used by the 'ice::json::value' constructor and assignment operator.
+  static void assign(json::value& self, const T& v)
+  {
+    json::object o;
+    o.reserve(count());
+    for_each_field(fields(), [&](const auto& field) {
+      using member_type = typename std::decay_t<decltype(field)>::member_type;
+      json::value e;
+      json_traits<member_type>::assign(e, v.*field.member);
+      o.append(json::name(std::string(field.name, field.size)), std::move(e));
+    }, sequence());
+    self.reset(std::move(o));
+  }
+
+  // Used by 'ice::json::value::is()'.
+  static bool is(const json::value& self)
+  {
+    return self.type() == json::type::object;
+  }
+
+  // Used by 'ice::json::value::as()'.
+  static T as(const json::value& self)
+  {
+    T v;
+    if (self.type() != json::type::object) {
+      return v;
+    }
+    for (const auto& e : self) {
+      find_field(fields(), *e.name, [&](const auto& field) {
+        using member_type = typename std::decay_t<decltype(field)>::member_type;
+        v.*field.member = e.value.template as<member_type>();
+      }, sequence());
+    }
+    return v;
+  }
+
+  // Used by 'ice::json::value::take()'.
+  static T take(json::value& self)
+  {
+    T v;
+    if (self.type() != json::type::object) {
+      return v;
+    }
+    for (auto& e : self) {
+      const auto& name = e.name;
+      find_field(fields(), *name, [&](const auto& field) {
+        using member_type = typename std::decay_t<decltype(field)>::member_type;
+        v.*field.member = e.value.template take<member_type>();
+      }, sequence());
+    }
+    return v;
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static T read(json::input& in)
+  {
+    T v;
+    if (in.type() != json::type::object) {
+      in.skip();
+      return v;
+    }
+    in.start_object();
+    ice::string_view key;
+    while (in.next_key(key)) {
+      auto found = find_field(fields(), key, [&](const auto& field) {
+        using member_type = typename std::decay_t<decltype(field)>::member_type;
+        v.*field.member = in.template read<member_type>();
+      }, sequence());
+      if (!found) {
+        in.skip();
+      }
+    }
+    return v;
+  }
+
+private:
+  // Returns the field descriptions, which are created at compile time.
+  static const auto& fields() noexcept
+  {
+    static constexpr auto v = Traits::fields();
+    return v;
+  }
+
+  static constexpr std::size_t count() noexcept
+  {
+    return std::tuple_size<std::decay_t<decltype(Traits::fields())>>::value;
+  }
+
+  static auto sequence() noexcept
+  {
+    return std::make_index_sequence<count()>();
+  }
+};
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
+
+// Implementation details of 'ICE_JSON_FIELDS'.
+#define ICE_JSON_F_X(x) x
+#define ICE_JSON_F_CONCAT(a, b) ICE_JSON_F_CONCAT_(a, b)
+#define ICE_JSON_F_CONCAT_(a, b) a##b
+#define ICE_JSON_F_FIELD(type, name) ::ice::json::detail::make_field(#name, &type::name)
+#define ICE_JSON_F_COUNT(...) \
+  ICE_JSON_F_X(ICE_JSON_F_COUNT_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, \
+    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define ICE_JSON_F_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, \
+  _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, n, ...) n
+#define ICE_JSON_F_FOR_EACH(type, ...) \
+  ICE_JSON_F_X(ICE_JSON_F_CONCAT(ICE_JSON_F_, ICE_JSON_F_COUNT(__VA_ARGS__))(type, __VA_ARGS__))
+#define ICE_JSON_F_1(t, a) ICE_JSON_F_FIELD(t, a)
+#define ICE_JSON_F_2(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_1(t, __VA_ARGS__))
+#define ICE_JSON_F_3(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_2(t, __VA_ARGS__))
+#define ICE_JSON_F_4(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_3(t, __VA_ARGS__))
+#define ICE_JSON_F_5(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_4(t, __VA_ARGS__))
+#define ICE_JSON_F_6(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_5(t, __VA_ARGS__))
+#define ICE_JSON_F_7(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_6(t, __VA_ARGS__))
+#define ICE_JSON_F_8(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_7(t, __VA_ARGS__))
+#define ICE_JSON_F_9(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_8(t, __VA_ARGS__))
+#define ICE_JSON_F_10(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_9(t, __VA_ARGS__))
+#define ICE_JSON_F_11(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_10(t, __VA_ARGS__))
+#define ICE_JSON_F_12(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_11(t, __VA_ARGS__))
+#define ICE_JSON_F_13(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_12(t, __VA_ARGS__))
+#define ICE_JSON_F_14(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_13(t, __VA_ARGS__))
+#define ICE_JSON_F_15(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_14(t, __VA_ARGS__))
+#define ICE_JSON_F_16(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_15(t, __VA_ARGS__))
+#define ICE_JSON_F_17(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_16(t, __VA_ARGS__))
+#define ICE_JSON_F_18(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_17(t, __VA_ARGS__))
+#define ICE_JSON_F_19(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_18(t, __VA_ARGS__))
+#define ICE_JSON_F_20(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_19(t, __VA_ARGS__))
+#define ICE_JSON_F_21(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_20(t, __VA_ARGS__))
+#define ICE_JSON_F_22(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_21(t, __VA_ARGS__))
+#define ICE_JSON_F_23(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_22(t, __VA_ARGS__))
+#define ICE_JSON_F_24(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_23(t, __VA_ARGS__))
+#define ICE_JSON_F_25(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_24(t, __VA_ARGS__))
+#define ICE_JSON_F_26(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_25(t, __VA_ARGS__))
+#define ICE_JSON_F_27(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_26(t, __VA_ARGS__))
+#define ICE_JSON_F_28(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_27(t, __VA_ARGS__))
+#define ICE_JSON_F_29(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_28(t, __VA_ARGS__))
+#define ICE_JSON_F_30(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_29(t, __VA_ARGS__))
+#define ICE_JSON_F_31(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_30(t, __VA_ARGS__))
+#define ICE_JSON_F_32(t, a, ...) ICE_JSON_F_FIELD(t, a), ICE_JSON_F_X(ICE_JSON_F_31(t, __VA_ARGS__))
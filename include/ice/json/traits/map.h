@@ -1,4 +1,5 @@
 #pragma once
+#include <ice/json/input.h>
 #include <ice/json/traits.h>
 #include <ice/json/value.h>
 #include <map>
@@ -41,7 +42,7 @@ struct json_traits<std::map<V, T>> {
     auto type = self.type();
     if (type == json::type::object) {
       for (const auto& e : self) {
-        v[json::value(e.name.value()).as<V>()] = e.value.as<T>();
+        v[json::value(json::string(e.name.value())).as<V>()] = e.value.as<T>();
       }
     } else if (type == json::type::array) {
       std::size_t index = 0;
@@ -52,6 +53,53 @@ struct json_traits<std::map<V, T>> {
     }
     return v;
   }
+
+  // Used by 'ice::json::value::take()'.
+  static std::map<V, T> take(json::value& self)
+  {
+    std::map<V, T> v;
+    auto type = self.type();
+    if (type == json::type::object) {
+      for (auto& e : self) {
+        v[json::value(e.name.take()).as<V>()] = e.value.take<T>();
+      }
+      self.reset();
+    } else if (type == json::type::array) {
+      std::size_t index = 0;
+      for (auto& e : self) {
+        v[json::value(index).as<V>()] = e.value.take<T>();
+        index++;
+      }
+    }
+    return v;
+  }
+
+  // Used by 'ice::json::input::read()'.
+  static std::map<V, T> read(json::input& in)
+  {
+    std::map<V, T> v;
+    auto type = in.type();
+    if (type == json::type::object) {
+      in.start_object();
+      ice::string_view key;
+      while (in.next_key(key)) {
+        // The key is only valid until the value is read.
+        auto& e = v[json::value(json::string(key.data(), key.size())).as<V>()];
+        e = in.read<T>();
+      }
+    } else if (type == json::type::array) {
+      std::size_t index = 0;
+      in.start_array();
+      while (in.next_element()) {
+        auto& e = v[json::value(index).as<V>()];
+        e = in.read<T>();
+        index++;
+      }
+    } else {
+      in.skip();
+    }
+    return v;
+  }
 };
 
 }  // namespace ice
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
+#include <ice/json/arena.h>
 #include <ice/optional.h>
+#include <ice/string_view.h>
+#include <atomic>
 #include <initializer_list>
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
+#include <cstdint>
 
 namespace ice {
 
@@ -14,7 +19,7 @@ struct json_traits;
 
 namespace json {
 
-enum struct type {
+enum struct type : std::uint8_t {
   null, boolean, number, string, array, object
 };
 
@@ -62,12 +67,124 @@ using number = double;
 // Json string value.
 using string = std::string;
 
+class keys;
+
+namespace detail {
+
+// FNV-1a hash of an object element name folded to 32 bits.
+// Used by the object hash index, 'ice::json::keys' and 'ICE_JSON_FIELDS', which must agree on it.
+constexpr std::uint32_t name_hash(const char* data, std::size_t size) noexcept
+{
+  std::uint64_t h = 0xCBF29CE484222325;
+  for (std::size_t i = 0; i < size; i++) {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 0x100000001B3;
+  }
+  return static_cast<std::uint32_t>(h ^ (h >> 32));
+}
+
+}  // namespace detail
+
+// Json object element name.
+// Provides the 'ice::optional<std::string>' interface, but only stores a pointer so that array elements stay small.
+// Names created by 'ice::json::keys' share their string with other names and must not be modified in place.
+class name {
+public:
+  name() noexcept = default;
+  name(name&& other) noexcept : data_(other.data_)
+  {
+    other.data_ = 0;
+  }
+
+  name(const name& other);
+
+  name(std::string value);
+
+  // Constructs a name that allocates the string with the given allocator.
+  name(std::string value, const json::allocator<std::string>& allocator);
+
+  ~name()
+  {
+    reset();
+  }
+
+  name& operator=(name&& other) noexcept;
+  name& operator=(const name& other);
+  name& operator=(std::string value);
+
+  explicit operator bool() const noexcept
+  {
+    return data_ != 0;
+  }
+
+  bool has_value() const noexcept
+  {
+    return data_ != 0;
+  }
+
+  // Returns a reference to the name string. Mutable access copies a shared name first, so that other names that share
+  // the string are not modified.
+  // Throws 'ice::bad_optional_access' if the name is not set.
+  std::string& value();
+  const std::string& value() const;
+
+  std::string& operator*()
+  {
+    return *detach();
+  }
+
+  const std::string& operator*() const noexcept
+  {
+    return *get();
+  }
+
+  std::string* operator->()
+  {
+    return detach();
+  }
+
+  const std::string* operator->() const noexcept
+  {
+    return get();
+  }
+
+  // Removes the name.
+  void reset() noexcept;
+
+  // Returns the name string and removes the name. Owned strings are moved and shared strings are copied.
+  // Throws 'ice::bad_optional_access' if the name is not set.
+  std::string take();
+
+private:
+  // Constructs a name that shares the given string, which is owned by 'ice::json::keys'.
+  explicit name(std::string* shared) noexcept : data_(reinterpret_cast<std::uintptr_t>(shared) | 2)
+  {}
+
+  // Pointer to the name string. The lowest bit is set if the string is allocated from an arena and the second bit is
+  // set if the string is shared.
+  std::string* get() const noexcept
+  {
+    return reinterpret_cast<std::string*>(data_ & ~std::uintptr_t(3));
+  }
+
+  // Replaces a shared name with an owned copy and returns the pointer to the name string.
+  std::string* detach();
+
+  std::uintptr_t data_ = 0;
+
+  friend class keys;
+};
+
+bool operator==(const name& a, const name& b);
+bool operator!=(const name& a, const name& b);
+bool operator<(const name& a, const name& b);
+
 // Json array or object element.
 template <typename T>
 struct element {
   // Json object element name.
-  // Should not be set when element is part of an array. Must not be set when element is part of an object.
-  ice::optional<std::string> name;
+  // Should not be set when element is part of an array. Must be set when element is part of an object.
+  json::name name;
 
   // Json object element or array element value.
   T value;
@@ -77,6 +194,9 @@ struct element {
 
   element(std::string name, T value) : name(std::move(name)), value(std::move(value))
   {}
+
+  element(json::name name, T value) : name(std::move(name)), value(std::move(value))
+  {}
 };
 
 template <typename T>
@@ -125,7 +245,7 @@ class value;
 
 // Used as the base class for both, array and object json values. This allows the use of a single iterator type for both types.
 // Thes array and object types cannot be typedefs because they have separate type_traits specializations.
-using collection = std::vector<element<value>>;
+using collection = std::vector<element<value>, json::allocator<element<value>>>;
 
 // Json value iterator.
 using iterator = collection::iterator;
@@ -146,6 +266,9 @@ public:
   array(array&& other) = default;
   array(const array& other) = default;
 
+  // Constructs an empty array that allocates its elements with the given allocator.
+  explicit array(const allocator_type& allocator);  // defined in value.h
+
   // Constructs a new array from an initializer list.
   // Usage: ice::json::value root = ice::json::array{ 1, "two", "three", 4 };
   explicit array(std::initializer_list<value> list);  // defined in value.h
@@ -155,18 +278,124 @@ public:
 };
 
 // Json object value.
+// Objects with 'index_threshold' or more elements keep a hash index of element names, which is created and updated by
+// the non-const 'find' and 'append' functions. Collection functions that add, remove or replace elements discard the
+// index. Iterators and element references keep it. Lookups verify the element that a matching slot refers to and
+// rebuild the index when elements were reordered. Renaming an element through a reference is not detected until the
+// number of elements changes; erase and append the element instead.
 class object : public collection {
 public:
+  // Minimum number of elements for the hash index.
+  static constexpr std::size_t index_threshold = 16;
+
   object() = default;
-  object(object&& other) = default;
-  object(const object& other) = default;
+  object(object&& other) noexcept;
+  object(const object& other);
+
+  // Constructs an empty object that allocates its elements with the given allocator.
+  explicit object(const allocator_type& allocator);  // defined in value.h
 
   // Constructs a new object from an initializer list.
   // Usage: ice::json::value root = ice::json::object{ { 1, "two" }, { "three", 4 } };
-  explicit object(std::initializer_list<std::initializer_list<value>> list);  // defined in value.cc
+  explicit object(std::initializer_list<std::initializer_list<value>> list);  // defined in value.h
+
+  ~object();
+
+  object& operator=(object&& other);
+  object& operator=(const object& other);
+
+  // Returns an iterator to the element with the given name or 'end()' if the name is not found.
+  iterator find(ice::string_view name);
+
+  // Returns a const iterator to the element with the given name or 'end()' if the name is not found.
+  // Uses the hash index if it is up to date, but never creates or updates it.
+  const_iterator find(ice::string_view name) const;
+
+  // Appends a new element without checking for duplicate names and returns a reference to the element value.
+  value& append(json::name name, value v);
+
+  // Collection functions that add, remove or replace elements discard the hash index (defined in value.h).
+  template <typename... Args>
+  iterator insert(Args&&... args);
+
+  template <typename... Args>
+  iterator emplace(Args&&... args);
+
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+
+  void push_back(const element<value>& e);
+  void push_back(element<value>&& e);
+
+  template <typename... Args>
+  iterator erase(Args&&... args);
+
+  void pop_back();
+  void clear() noexcept;
+
+  template <typename... Args>
+  void resize(Args&&... args);
+
+  template <typename... Args>
+  void assign(Args&&... args);
+
+private:
+  struct index;
+
+  // Discards the hash index before elements are added, removed or replaced.
+  void unindex() noexcept
+  {
+    if (index_) {
+      release();
+    }
+  }
+
+  std::size_t lookup(const char* name, std::size_t size);
+  std::size_t lookup(const char* name, std::size_t size) const;
+  void reindex(std::size_t capacity);
+  void release() noexcept;
+
+  index* index_ = nullptr;
+};
+
+// Json array of numbers stored contiguously instead of one 'ice::json::element' per number.
+// The parser and 'ice::json_traits<std::vector<T>>' store arrays with 'threshold' or more numbers in this form if
+// every number is exact as a double. Such a json value still has the 'array' type. Non-const access through the
+// 'ice::json::array' interface converts it to a regular array. Const access creates the array elements once and keeps
+// them until the numbers are accessed through a non-const reference.
+class numbers : public std::vector<number, json::allocator<number>> {
+public:
+  // Minimum number of elements stored as numbers by the parser and 'ice::json_traits<std::vector<T>>'.
+  static constexpr std::size_t threshold = 16;
+
+  numbers() = default;
+  numbers(numbers&& other) noexcept;
+  numbers(const numbers& other);
+
+  // Constructs empty numbers that allocate their elements with the given allocator.
+  explicit numbers(const allocator_type& allocator);
+
+  // Constructs new numbers from an initializer list.
+  // Usage: ice::json::value samples{ ice::json::numbers{ 0.5, 1.0, 1.5 } };
+  numbers(std::initializer_list<number> list);
+
+  ~numbers();
+
+  numbers& operator=(numbers&& other);
+  numbers& operator=(const numbers& other);
+
+private:
+  // Returns the array elements for const access through the 'ice::json::array' interface.
+  // Concurrent calls are safe, the elements are created at most once.
+  const array& elements() const;
+
+  // Discards the array elements.
+  void release() noexcept;
+
+  mutable std::atomic<array*> elements_{ nullptr };
 
-  object& operator=(object&& other) = default;
-  object& operator=(const object& other) = default;
+  friend class value;
+  friend struct ice::json_traits<numbers>;
 };
 
 template <typename T>
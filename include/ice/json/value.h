@@ -2,22 +2,45 @@
 #include <ice/json/data.h>
 #include <ice/json/exception.h>
 #include <ice/json/types.h>
+#include <ice/string_view.h>
 #include <initializer_list>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <cstdint>
+#include <cstring>
 
 namespace ice {
 namespace json {
 
+class buffer;
+class value;
+
+namespace detail {
+
+class builder;
+
+// Checks if 'ice::json_traits<T>' implements 'static T take(ice::json::value& self)'.
+template <typename T, typename = void>
+struct has_take : std::false_type {};
+
+template <typename T>
+struct has_take<T, decltype(void(json_traits<T>::take(std::declval<value&>())))> : std::true_type {};
+
+}  // namespace detail
+
 // ECMA-404 The JSON Data Interchange Standard implementation.
 class value {
 public:
+  // Maximum size of strings that are stored in the json value instead of on the heap.
+  static constexpr std::size_t short_size = 14;
+
   // Constructs a 'null' json value.
   value() = default;
 
-  value(value&& other);
+  value(value&& other) noexcept;
   value(const value& other);
 
   // Constructs a json value from the given parameter.
@@ -25,7 +48,7 @@ public:
   template <typename T>
   explicit value(T&& value)
   {
-    json_traits<std::remove_reference_t<T>>::assign(*this, std::forward<T>(value));
+    json_traits<std::decay_t<T>>::assign(*this, std::forward<T>(value));
   }
 
   // Constructs a new array or object from an initializer list.
@@ -35,7 +58,7 @@ public:
 
   ~value();
 
-  value& operator=(value&& other);
+  value& operator=(value&& other) noexcept;
   value& operator=(const value& other);
 
   // Assigns a new json value from the given parameter.
@@ -44,7 +67,7 @@ public:
   value& operator=(T&& value)
   {
     clear();
-    json_traits<std::remove_reference_t<T>>::assign(*this, std::forward<T>(value));
+    json_traits<std::decay_t<T>>::assign(*this, std::forward<T>(value));
     return *this;
   }
 
@@ -68,6 +91,9 @@ public:
   }
 
   // Returns a const reference to the underlying basic value.
+  // Short strings and strings that refer to a document buffer are not stored as 'std::string' and throw
+  // 'ice::json::type_error'. Use 'as<ice::string_view>()' to read any string, or the non-const 'data()', which moves
+  // the string to the heap.
   // Throws 'ice::json::type_error' in case of a non-basic json value type.
   template <typename T>
   const T& data() const
@@ -78,11 +104,28 @@ public:
   // Converts the underlying basic value to the provided template parameter value type.
   // In case of a non-basic json value type template parameter, the user-provided 'ice::json_traits' are used.
   template <typename T>
-  T as() const
+  T as() const&
   {
     return json_traits<T>::as(*this);
   }
 
+  // Converts a json value rvalue to the provided template parameter value type (see 'take()').
+  template <typename T>
+  T as() &&
+  {
+    return take<T>();
+  }
+
+  // Converts the underlying basic value to the provided template parameter value type and moves strings, arrays and
+  // objects into the result instead of copying them. The json value is left in a valid but unspecified state.
+  // Uses 'ice::json_traits<T>::take()' if available and 'ice::json_traits<T>::as()' otherwise.
+  // Usage: auto orders = ice::json::parse(text).take<std::vector<order>>();
+  template <typename T>
+  T take()
+  {
+    return take<T>(detail::has_take<T>());
+  }
+
   // Returns true if the json value is an empty array, an empty object or any other json value type.
   bool empty() const noexcept;
 
@@ -100,7 +143,7 @@ public:
     if (type_ != json::type::array) {
       reset(json::type::array);
     }
-    return data_.array.push_back(std::forward<T>(value));
+    return elements().push_back(std::forward<T>(value));
   }
 
   // Returns a reference to the requested array element.
@@ -119,24 +162,27 @@ public:
   void erase(std::size_t index);
 
   // Initializes an object and returns a reference to the requested element value.
-  value& operator[](const std::string& key);
+  value& operator[](ice::string_view key);
 
   // Returns a reference to the requested element value.
   // Throws 'ice::json::type_error' if the json value is not an object.
   // Throws 'ice::json::range_error' if the given key is not found.
-  const value& operator[](const std::string& key) const;
+  const value& operator[](ice::string_view key) const;
 
   // Returns an iterator to the requested object element.
   // Returns 'end()' if the given key is not found or the json value is not an object.
-  iterator find(const std::string& key) noexcept;
+  iterator find(ice::string_view key) noexcept;
 
   // Returns a const iterator to the requested object element.
   // Returns 'end()' if the given key is not found or the json value is not an object.
-  const_iterator find(const std::string& key) const noexcept;
+  const_iterator find(ice::string_view key) const noexcept;
+
+  // Returns true if the json value is an object that contains the given key.
+  bool contains(ice::string_view key) const noexcept;
 
   // Erases an object element.
   // Returns 'end()' if the given key is not found or the json value is not an object.
-  iterator erase(const std::string& key) noexcept;
+  iterator erase(ice::string_view key) noexcept;
 
   // Returns an iterator to the first element of an array or object json value.
   iterator begin() noexcept;
@@ -201,15 +247,27 @@ public:
   // Resets the json value type to 'number' and assigns the given value.
   void reset(number v);
 
+  // Resets the json value type to 'number' and assigns the given integer.
+  // Integers that can not be represented by a double exactly are kept exact (see 'as_integer()').
+  void reset(std::int64_t v);
+
   // Resets the json value type to 'string' and assigns the given value.
+  // Strings of up to 'short_size' bytes are stored in the json value itself.
   void reset(string v);
 
+  // Resets the json value type to 'string' and assigns the given value.
+  // The string is allocated with the given allocator unless it is short. Arrays and objects use their own allocator.
+  void reset(string v, const json::allocator<string>& allocator);
+
   // Resets the json value type to 'array' and assigns the given value.
   void reset(array v);
 
   // Resets the json value type to 'object' and assigns the given value.
   void reset(object v);
 
+  // Resets the json value type to 'array' and stores the given numbers contiguously (see 'ice::json::numbers').
+  void reset(numbers v);
+
   // Returns the json value as a boolean.
   boolean as_boolean() const noexcept;
 
@@ -219,9 +277,89 @@ public:
   // Returns the json value as a string.
   string as_string() const noexcept;
 
+  // Returns true if the json value is a number that keeps an integer, which can not be represented by a double exactly.
+  bool has_integer() const noexcept;
+
+  // Returns the json value as a 64-bit integer.
+  // Integer numbers are returned exactly. Other numbers are truncated and clamped to the integer range.
+  std::int64_t as_integer() const noexcept;
+
 private:
+  template <typename T>
+  T take(std::true_type)
+  {
+    return json_traits<T>::take(*this);
+  }
+
+  template <typename T>
+  T take(std::false_type)
+  {
+    return json_traits<T>::as(*this);
+  }
+
+  template <typename T>
+  void destroy(T* p) noexcept;
+
+  // Returns the array elements. Converts arrays stored as 'ice::json::numbers' to regular arrays.
+  array& elements();
+
+  // Returns the array elements. Arrays stored as 'ice::json::numbers' create the elements once and keep them.
+  const array& elements() const;
+
+  // Returns the object elements. Const access keeps the object hash index.
+  const object& members() const noexcept
+  {
+    return *data_.object;
+  }
+
+  // Returns the characters of a short string, which are stored in the first 'short_size' bytes of the json value.
+  char* short_data() noexcept
+  {
+    return reinterpret_cast<char*>(this);
+  }
+
+  const char* short_data() const noexcept
+  {
+    return reinterpret_cast<const char*>(this);
+  }
+
+  // Returns the string characters.
+  ice::string_view text() const noexcept
+  {
+    if (flags_ & short_flag) {
+      return { short_data(), static_cast<std::size_t>(flags_ >> 4) };
+    }
+    if (flags_ & view_flag) {
+      std::uint32_t size = 0;
+      std::memcpy(&size, chars_, sizeof(size));
+      return { data_.chars, size };
+    }
+    return { data_.string->data(), data_.string->size() };
+  }
+
+  // Stores a short string in the json value.
+  void reset_short(const char* data, std::size_t size) noexcept;
+
+  // Refers to string characters that are owned by a document. The size must fit into 'chars_'.
+  void reset_view(const char* data, std::size_t size) noexcept;
+
+  // Moves a short or view string to the heap and returns it.
+  string& unshort();
+
+  // Bits of 'flags_', which depend on the json value type. The upper 4 bits hold the size of a short string.
+  enum : std::uint8_t {
+    arena_flag = 1,    // the string, array or object is allocated from an arena
+    integer_flag = 2,  // the number is an integer that is 'rounding_' away from the nearest double
+    view_flag = 2,     // the string refers to 'chars_' bytes at 'data_.chars' in a document buffer
+    packed_flag = 4,   // the array is stored as 'ice::json::numbers'
+    short_flag = 8,    // the string is stored in the json value (see 'short_data()')
+  };
+
   json::data data_;
+  std::int16_t rounding_ = 0;  // at most 2^9 for integers below 2^63
+  char chars_[4] = {};         // only used by short and view strings
   json::type type_ = json::type::null;
+  std::uint8_t flags_ = 0;
 
   friend struct json_traits<json::type>;
   friend struct json_traits<json::null>;
@@ -230,9 +368,18 @@ private:
   friend struct json_traits<json::string>;
   friend struct json_traits<json::array>;
   friend struct json_traits<json::object>;
-  friend std::ostream& format(std::ostream& os, const value& root, bool pretty, std::size_t offset);
+  friend struct json_traits<json::numbers>;
+  friend struct json_traits<ice::string_view>;
+  friend class detail::builder;
+  friend void format(buffer& out, const value& root, bool pretty, std::size_t offset);
 };
 
+template <>
+inline value value::take<value>()
+{
+  return std::move(*this);
+}
+
 bool operator==(const value& a, const value& b);
 bool operator!=(const value& a, const value& b);
 bool operator<(const value& a, const value& b);
@@ -242,6 +389,9 @@ bool operator>=(const value& a, const value& b);
 
 std::ostream& operator<<(std::ostream& os, const value& root);
 
+inline array::array(const allocator_type& allocator) : collection(allocator)
+{}
+
 inline array::array(std::initializer_list<value> list)
 {
   for (const auto& e : list) {
@@ -249,6 +399,9 @@ inline array::array(std::initializer_list<value> list)
   }
 }
 
+inline object::object(const allocator_type& allocator) : collection(allocator)
+{}
+
 inline object::object(std::initializer_list<std::initializer_list<value>> list)
 {
   for (const auto& e : list) {
@@ -259,5 +412,71 @@ inline object::object(std::initializer_list<std::initializer_list<value>> list)
   }
 }
 
+template <typename... Args>
+inline iterator object::insert(Args&&... args)
+{
+  unindex();
+  return collection::insert(std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+inline iterator object::emplace(Args&&... args)
+{
+  unindex();
+  return collection::emplace(std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+inline void object::emplace_back(Args&&... args)
+{
+  unindex();
+  collection::emplace_back(std::forward<Args>(args)...);
+}
+
+inline void object::push_back(const element<value>& e)
+{
+  unindex();
+  collection::push_back(e);
+}
+
+inline void object::push_back(element<value>&& e)
+{
+  unindex();
+  collection::push_back(std::move(e));
+}
+
+template <typename... Args>
+inline iterator object::erase(Args&&... args)
+{
+  unindex();
+  return collection::erase(std::forward<Args>(args)...);
+}
+
+inline void object::pop_back()
+{
+  unindex();
+  collection::pop_back();
+}
+
+inline void object::clear() noexcept
+{
+  unindex();
+  collection::clear();
+}
+
+template <typename... Args>
+inline void object::resize(Args&&... args)
+{
+  unindex();
+  collection::resize(std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+inline void object::assign(Args&&... args)
+{
+  unindex();
+  collection::assign(std::forward<Args>(args)...);
+}
+
 }  // namespace json
 }  // namespace ice
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+#include <ice/json/input.h>
+#include <ice/json/value.h>
+#include <ice/string_view.h>
+#include <iterator>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+
+// Read-only view of a json value in a contiguous buffer.
+// Nothing is parsed up front. Accessing an element scans the enclosing container and skips other values without
+// decoding them. Keys, strings and numbers are decoded when they are accessed and 'get()' materializes a subtree as a
+// regular json value. Skipped arrays and objects are only checked for terminated strings and nesting depth, so invalid
+// input is reported when the invalid part is accessed.
+// Duplicate object keys resolve to the last one, like 'ice::json::parse()'.
+// The buffer must outlive the view and all views created from it.
+// Usage: ice::json::view message(text); auto route = message["route"].as_string(); forward(text);
+class view {
+public:
+  class iterator;
+
+  // Creates an empty view (see 'operator bool()').
+  view() = default;
+
+  // Creates a view of the json value in the given buffer. Leading whitespace and a UTF-8 BOM are skipped.
+  view(const char* data, std::size_t size);
+
+  // Creates a view of the json value in the given string. The string must outlive the view.
+  explicit view(const std::string& text);
+
+  // Returns true if the view refers to a json value. Views returned by 'find()' are empty if the key was not found.
+  explicit operator bool() const noexcept;
+
+  // Returns the json value type based on the first character of the value.
+  // Throws 'ice::json::parse_error' if the view is empty or the value does not start with a valid character.
+  json::type type() const;
+
+  // Returns the raw json text of the value, which can be forwarded without serializing it again.
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  ice::string_view raw() const;
+
+  // Parses the viewed value into a json value.
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  value get() const;
+
+  // Returns the number of array or object elements. Returns 0 for other json value types.
+  std::size_t size() const;
+
+  // Returns a view of the requested array element.
+  // Throws 'ice::json::type_error' if the json value is not an array.
+  // Throws 'ice::json::range_error' if the given index is out of range.
+  view operator[](std::size_t index) const;
+
+  // Returns a view of the requested object element value.
+  // Throws 'ice::json::type_error' if the json value is not an object.
+  // Throws 'ice::json::range_error' if the given key is not found.
+  view operator[](ice::string_view key) const;
+
+  // Returns a view of the requested object element value.
+  // Returns an empty view if the given key is not found or the json value is not an object.
+  view find(ice::string_view key) const;
+
+  // Returns true if the json value is an object that contains the given key.
+  bool contains(ice::string_view key) const;
+
+  // Returns the json value as a boolean (see 'ice::json::value::as_boolean()').
+  boolean as_boolean() const;
+
+  // Returns the json value as a number (see 'ice::json::value::as_number()').
+  number as_number() const;
+
+  // Returns the json value as a 64-bit integer (see 'ice::json::value::as_integer()').
+  std::int64_t as_integer() const;
+
+  // Returns the decoded string or the raw json text for other json value types.
+  string as_string() const;
+
+  // Converts the viewed value using 'ice::json::input::read()'.
+  template <typename T>
+  T as() const
+  {
+    input in(begin_, it_, static_cast<std::size_t>(end_ - it_));
+    return in.read<T>();
+  }
+
+  // Returns an iterator to the first element of an array or object.
+  // Returns 'end()' for other json value types.
+  iterator begin() const;
+
+  // Returns the end iterator.
+  iterator end() const noexcept;
+
+private:
+  view(const char* begin, const char* it, const char* end) noexcept : begin_(begin), it_(it), end_(end)
+  {}
+
+  const char* skip(const char* it) const;
+  view lookup(ice::string_view key) const;
+  parse_error error(const char* message, const char* it) const;
+
+  const char* begin_ = nullptr;  // start of the buffer for error positions
+  const char* it_ = nullptr;     // first character of the value
+  const char* end_ = nullptr;    // end of the buffer
+
+  friend class iterator;
+};
+
+// Forward iterator over array or object elements.
+class view::iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = view;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const view*;
+  using reference = const view&;
+
+  iterator() = default;
+
+  // Returns a view of the element value.
+  const view& operator*() const noexcept
+  {
+    return value_;
+  }
+
+  const view* operator->() const noexcept
+  {
+    return &value_;
+  }
+
+  // Returns the decoded element name or an empty string for array elements.
+  string name() const;
+
+  iterator& operator++();
+
+  iterator operator++(int)
+  {
+    auto it = *this;
+    ++*this;
+    return it;
+  }
+
+  bool operator==(const iterator& other) const noexcept
+  {
+    return value_.it_ == other.value_.it_;
+  }
+
+  bool operator!=(const iterator& other) const noexcept
+  {
+    return value_.it_ != other.value_.it_;
+  }
+
+private:
+  iterator(const view& container, const char* it);
+
+  void read();
+
+  view value_;
+  const char* name_ = nullptr;  // opening quote of the element name
+  char close_ = ']';
+
+  friend class view;
+};
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,98 @@
+#pragma once
+#include <ice/json/buffer.h>
+#include <ice/json/traits.h>
+#include <ice/json/value.h>
+#include <ice/string_view.h>
+#include <ice/zlib.h>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+
+// Serializes a json document piece by piece without creating a json value.
+// Commas, escape sequences and the optional pretty printing match 'ice::json::format()'. Object elements are written
+// with 'key()' followed by a value, array elements as values. Exactly one root value can be written.
+// Throws 'std::logic_error' if a call does not fit the current position in the document, for example a value
+// without a key inside an object or an 'end_array()' that closes an object.
+// Usage: w.begin_object().key("id").value(42).key("tags").begin_array().value("a").end_array().end_object();
+class writer {
+public:
+  // Creates a writer that appends to the buffer. Fixed buffers are passed to their flush function when they are full.
+  explicit writer(buffer& out, bool pretty = false);
+
+  // Creates a writer that writes to the stream through an internal 4 KiB buffer.
+  explicit writer(std::ostream& os, bool pretty = false);
+
+  // Creates a writer that compresses the output and passes the compressed data to the handler.
+  // Call 'deflate.finish(handler)' after 'flush()' to complete the compressed stream.
+  writer(zlib::deflate& deflate, zlib::handler handler, bool pretty = false);
+
+  writer(writer&& other) = delete;
+  writer(const writer& other) = delete;
+
+  writer& operator=(writer&& other) = delete;
+  writer& operator=(const writer& other) = delete;
+
+  // Writes the opening '[' of an array.
+  writer& begin_array();
+
+  // Writes the closing ']' of the current array.
+  writer& end_array();
+
+  // Writes the opening '{' of an object.
+  writer& begin_object();
+
+  // Writes the closing '}' of the current object.
+  writer& end_object();
+
+  // Writes the name of the next object element.
+  writer& key(ice::string_view name);
+
+  // Writes a scalar value.
+  writer& value(json::null v);
+  writer& value(json::boolean v);
+  writer& value(json::number v);
+  writer& value(std::int64_t v);
+  writer& value(ice::string_view v);
+  writer& value(const char* v);
+
+  // Writes an integer value. Integers that can not be represented exactly are handled like in 'ice::json::value'.
+  template <typename T>
+  std::enable_if_t<is_numeric<T>::value, writer&> value(T v)
+  {
+    return value(json::value(v));
+  }
+
+  // Writes the json value with the indentation of the current position.
+  writer& value(const json::value& v);
+
+  // Returns true if the root value is complete.
+  bool done() const noexcept
+  {
+    return root_ && stack_.empty();
+  }
+
+  // Passes the buffered output to the stream or the deflate stream. Does nothing for growable buffers.
+  void flush();
+
+private:
+  void next();
+  void close(char c);
+
+  char data_[4096];
+  buffer own_;               // buffer for streams and deflate streams
+  buffer& out_;              // output buffer
+  std::vector<char> stack_;  // opening characters of the open arrays and objects
+  bool pretty_ = false;      // add spacing like 'ice::json::format()'
+  bool first_ = true;        // no element of the current array or object was written yet
+  bool key_ = false;         // a key was written and its value is next
+  bool root_ = false;        // the root value was started
+};
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,70 @@
+#include <ice/json/arena.h>
+#include <algorithm>
+#include <new>
+
+namespace ice {
+namespace json {
+namespace {
+
+// Block sizes grow geometrically up to this limit. Larger allocations still get a block of their own.
+constexpr std::size_t max_block_size = 16 * 1024 * 1024;
+
+}  // namespace
+
+arena::arena(std::size_t block_size) noexcept : block_size_(block_size)
+{}
+
+arena::~arena()
+{
+  while (head_) {
+    auto next = head_->next;
+    ::operator delete(head_);
+    head_ = next;
+  }
+}
+
+void arena::clear() noexcept
+{
+  if (!head_) {
+    return;
+  }
+  if (head_->next) {
+    // Replace multiple blocks with a single block that fits all of them the next time the arena is used.
+    block_size_ = std::max(block_size_, capacity());
+    while (head_) {
+      auto next = head_->next;
+      ::operator delete(head_);
+      head_ = next;
+    }
+    pos_ = nullptr;
+    end_ = nullptr;
+    return;
+  }
+  pos_ = reinterpret_cast<char*>(head_ + 1);
+  end_ = reinterpret_cast<char*>(head_) + head_->size;
+}
+
+std::size_t arena::capacity() const noexcept
+{
+  std::size_t size = 0;
+  for (auto it = head_; it; it = it->next) {
+    size += it->size;
+  }
+  return size;
+}
+
+void* arena::allocate_block(std::size_t size, std::size_t alignment)
+{
+  auto block_size = std::max(block_size_, sizeof(block) + size + alignment);
+  auto head = static_cast<block*>(::operator new(block_size));
+  head->next = head_;
+  head->size = block_size;
+  head_ = head;
+  pos_ = reinterpret_cast<char*>(head + 1);
+  end_ = reinterpret_cast<char*>(head) + block_size;
+  block_size_ = std::min(block_size_ * 2, std::max(block_size_, max_block_size));
+  return allocate(size, alignment);
+}
+
+}  // namespace json
+}  // namespace ice
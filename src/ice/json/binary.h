@@ -0,0 +1,210 @@
+#pragma once
+#include <ice/json/buffer.h>
+#include <ice/json/exception.h>
+#include <ice/json/value.h>
+#include <ice/string_view.h>
+#include <ice/utf8.h>
+#include <istream>
+#include <string>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ice {
+namespace json {
+namespace detail {
+
+// Maximum nesting depth of arrays and objects in binary encodings, which are decoded recursively.
+constexpr std::size_t max_binary_depth = 1024;
+
+// Appends the lowest 'size' bytes of the value in big-endian byte order.
+inline void append_be(buffer& out, std::uint64_t v, std::size_t size)
+{
+  char data[8];
+  for (auto i = size; i > 0; i--) {
+    data[i - 1] = static_cast<char>(v & 0xFF);
+    v >>= 8;
+  }
+  out.append(data, size);
+}
+
+inline std::uint32_t float_bits(float v) noexcept
+{
+  std::uint32_t bits = 0;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+
+inline std::uint64_t double_bits(double v) noexcept
+{
+  std::uint64_t bits = 0;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+
+// Returns true if the double can be stored as a float without losing precision.
+inline bool is_float(double v) noexcept
+{
+  return static_cast<double>(static_cast<float>(v)) == v;
+}
+
+// Stores the number as an integer if it is integral and exact in a double or an exact 64-bit integer.
+// Larger integral doubles are not converted, so that they are not decoded as exact integers. Negative zero is not
+// converted either.
+inline bool to_integer(const value& v, std::int64_t& i) noexcept
+{
+  constexpr double max_exact = 9007199254740992.0;  // 2^53
+  if (v.has_integer()) {
+    i = v.as_integer();
+    return true;
+  }
+  auto n = v.as_number();
+  if (!(n >= -max_exact && n <= max_exact) || (n == 0 && std::signbit(n))) {
+    return false;
+  }
+  if (static_cast<double>(static_cast<std::int64_t>(n)) == n) {
+    i = static_cast<std::int64_t>(n);
+    return true;
+  }
+  return false;
+}
+
+// Reads binary data from a contiguous buffer. Strings are returned as views into the buffer.
+class buffer_source {
+public:
+  buffer_source(const char* data, std::size_t size) noexcept : begin_(data), it_(data), end_(data + size)
+  {}
+
+  std::uint8_t peek()
+  {
+    if (it_ == end_) {
+      throw error("incomplete input");
+    }
+    return static_cast<std::uint8_t>(*it_);
+  }
+
+  std::uint8_t next()
+  {
+    auto c = peek();
+    ++it_;
+    return c;
+  }
+
+  // Reads an unsigned big-endian integer with the given number of bytes.
+  std::uint64_t read(std::size_t size)
+  {
+    if (static_cast<std::size_t>(end_ - it_) < size) {
+      throw error("incomplete input");
+    }
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < size; i++) {
+      v = (v << 8) | static_cast<std::uint8_t>(*it_++);
+    }
+    return v;
+  }
+
+  // Reads the given number of bytes.
+  ice::string_view read_string(std::uint64_t size)
+  {
+    if (static_cast<std::uint64_t>(end_ - it_) < size) {
+      throw error("incomplete input");
+    }
+    ice::string_view v(it_, static_cast<std::size_t>(size));
+    it_ += size;
+    return v;
+  }
+
+  parse_error error(const char* message) const
+  {
+    return std::string(message) + " (offset " + std::to_string(it_ - begin_) + ")";
+  }
+
+private:
+  const char* begin_;
+  const char* it_;
+  const char* end_;
+};
+
+// Reads binary data from a stream. Only reads the bytes of the decoded value.
+class stream_source {
+public:
+  explicit stream_source(std::istream& is) noexcept : is_(is)
+  {}
+
+  std::uint8_t peek()
+  {
+    auto c = is_.peek();
+    if (c == std::char_traits<char>::eof()) {
+      throw error("incomplete input");
+    }
+    return static_cast<std::uint8_t>(c);
+  }
+
+  std::uint8_t next()
+  {
+    auto c = peek();
+    is_.get();
+    offset_++;
+    return c;
+  }
+
+  std::uint64_t read(std::size_t size)
+  {
+    char data[8];
+    read(data, size);
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < size; i++) {
+      v = (v << 8) | static_cast<std::uint8_t>(data[i]);
+    }
+    return v;
+  }
+
+  // Reads the given number of bytes. The result is valid until the next call.
+  ice::string_view read_string(std::uint64_t size)
+  {
+    // Grows the string in steps, so that a corrupted size does not allocate more memory than the stream contains.
+    constexpr std::uint64_t step = 64 * 1024;
+    string_.clear();
+    while (string_.size() < size) {
+      auto pos = string_.size();
+      auto count = static_cast<std::size_t>(size - pos < step ? size - pos : step);
+      string_.resize(pos + count);
+      read(&string_[pos], count);
+    }
+    return string_;
+  }
+
+  parse_error error(const char* message) const
+  {
+    return std::string(message) + " (offset " + std::to_string(offset_) + ")";
+  }
+
+private:
+  void read(char* data, std::size_t size)
+  {
+    is_.read(data, static_cast<std::streamsize>(size));
+    offset_ += static_cast<std::size_t>(is_.gcount());
+    if (static_cast<std::size_t>(is_.gcount()) != size) {
+      throw error("incomplete input");
+    }
+  }
+
+  std::istream& is_;
+  std::size_t offset_ = 0;
+  std::string string_;
+};
+
+// Throws 'ice::json::parse_error' if the string is not valid UTF-8.
+template <typename Source>
+inline ice::string_view check_utf8(const Source& source, ice::string_view v)
+{
+  if (!is_valid_utf8(v)) {
+    throw source.error("invalid UTF-8");
+  }
+  return v;
+}
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
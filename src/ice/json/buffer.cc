@@ -0,0 +1,92 @@
+#include <ice/json/buffer.h>
+#include <algorithm>
+
+namespace ice {
+namespace json {
+namespace {
+
+// Initial size of growable buffers.
+constexpr std::size_t min_capacity = 256;
+
+}  // namespace
+
+buffer::buffer(char* data, std::size_t size, flush_function flush) :
+  flush_(std::move(flush)), begin_(data), pos_(data), end_(data + size)
+{}
+
+void buffer::append(std::size_t count, char c)
+{
+  while (count > 0) {
+    if (pos_ == end_) {
+      overflow(count);
+    }
+    auto size = std::min(count, static_cast<std::size_t>(end_ - pos_));
+    std::memset(pos_, c, size);
+    pos_ += size;
+    count -= size;
+  }
+}
+
+void buffer::reserve(std::size_t size)
+{
+  if (size <= static_cast<std::size_t>(end_ - pos_)) {
+    return;
+  }
+  if (!flush_) {
+    overflow(size);
+  } else if (size <= capacity()) {
+    flush();
+  }
+}
+
+void buffer::flush()
+{
+  if (flush_ && pos_ != begin_) {
+    flush_(begin_, size());
+    pos_ = begin_;
+  }
+}
+
+std::string buffer::release()
+{
+  if (flush_) {
+    std::string s(begin_, size());
+    pos_ = begin_;
+    return s;
+  }
+  storage_.resize(size());
+  auto s = std::move(storage_);
+  storage_.clear();
+  begin_ = nullptr;
+  pos_ = nullptr;
+  end_ = nullptr;
+  return s;
+}
+
+// Flushes a fixed buffer or grows a growable buffer, so that 'size' more characters fit.
+void buffer::overflow(std::size_t size)
+{
+  if (flush_) {
+    flush();
+    return;
+  }
+  auto used = this->size();
+  storage_.resize(std::max({ storage_.size() * 2, used + size, min_capacity }));
+  begin_ = &storage_[0];
+  pos_ = begin_ + used;
+  end_ = begin_ + storage_.size();
+}
+
+// Makes room for the given characters. Returns false if they were passed to the flush function directly.
+bool buffer::overflow(const char* data, std::size_t size)
+{
+  overflow(size);
+  if (size <= static_cast<std::size_t>(end_ - pos_)) {
+    return true;
+  }
+  flush_(data, size);
+  return false;
+}
+
+}  // namespace json
+}  // namespace ice
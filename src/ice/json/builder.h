@@ -0,0 +1,171 @@
+#pragma once
+#include <ice/json/keys.h>
+#include <ice/json/traits.h>
+#include <ice/json/value.h>
+#include <ice/string_view.h>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+namespace detail {
+
+// Builds a json value from 'ice::json::detail::reader' events.
+// Container elements are collected on an explicit stack and moved into the container once it is complete.
+// This way each array or object is allocated exactly once using the given allocator. Arrays of numbers are stored as
+// 'ice::json::numbers' (see 'ice::json::numbers::threshold').
+class builder {
+public:
+  // Object element names are interned in the given table if it is not null.
+  // Strings that are not short refer to the input instead of being copied if 'views' is true. Use this only with a
+  // reader that decodes strings in place (see 'ice::json::detail::in_situ') and an input that outlives the values.
+  explicit builder(
+    value& root, const json::allocator<element<value>>& allocator = {}, json::keys* keys = nullptr, bool views = false) :
+    root_(root), allocator_(allocator), keys_(keys), views_(views)
+  {
+    stack_.reserve(32);
+    elements_.reserve(256);
+  }
+
+  bool on_null()
+  {
+    next().reset();
+    return true;
+  }
+
+  bool on_boolean(boolean v)
+  {
+    next().reset(v);
+    return true;
+  }
+
+  bool on_number(number v)
+  {
+    next(true).reset(v);
+    return true;
+  }
+
+  bool on_integer(std::int64_t v)
+  {
+    auto& e = next(true);
+    e.reset(v);
+    if (e.has_integer() && !stack_.empty()) {
+      stack_.back().numbers = false;
+    }
+    return true;
+  }
+
+  bool on_string(ice::string_view v)
+  {
+    if (views_ && v.size() > value::short_size && v.size() <= std::numeric_limits<std::uint32_t>::max()) {
+      next().reset_view(v.data(), v.size());
+    } else {
+      next().reset(string(v.data(), v.size()), allocator_);
+    }
+    return true;
+  }
+
+  bool on_key(ice::string_view v)
+  {
+    key_.assign(v.data(), v.size());
+    return true;
+  }
+
+  bool on_start_array()
+  {
+    stack_.push_back({ type::array, elements_.size(), std::string(), true });
+    return true;
+  }
+
+  bool on_end_array()
+  {
+    auto begin = elements_.begin() + static_cast<std::ptrdiff_t>(stack_.back().index);
+    if (stack_.back().numbers && static_cast<std::size_t>(elements_.end() - begin) >= numbers::threshold) {
+      numbers v(allocator_);
+      v.reserve(static_cast<std::size_t>(elements_.end() - begin));
+      for (auto it = begin; it != elements_.end(); ++it) {
+        v.push_back(it->value.data<number>());
+      }
+      elements_.erase(begin, elements_.end());
+      stack_.pop_back();
+      next().reset(std::move(v));
+      return true;
+    }
+    array v(allocator_);
+    v.reserve(static_cast<std::size_t>(elements_.end() - begin));
+    for (auto it = begin; it != elements_.end(); ++it) {
+      v.emplace_back(std::move(it->value));
+    }
+    elements_.erase(begin, elements_.end());
+    stack_.pop_back();
+    next().reset(std::move(v));
+    return true;
+  }
+
+  bool on_start_object()
+  {
+    stack_.push_back({ type::object, elements_.size(), std::move(key_), true });
+    return true;
+  }
+
+  bool on_end_object()
+  {
+    auto begin = elements_.begin() + static_cast<std::ptrdiff_t>(stack_.back().index);
+    value v{ object(allocator_) };
+    auto& o = v.data<object>();
+    o.reserve(static_cast<std::size_t>(elements_.end() - begin));
+    for (auto it = begin; it != elements_.end(); ++it) {
+      const auto& name = it->name;
+      auto pos = o.find(name.value());
+      if (pos == o.end()) {
+        o.append(std::move(it->name), std::move(it->value));
+      } else {
+        pos->value = std::move(it->value);
+      }
+    }
+    elements_.erase(begin, elements_.end());
+    key_ = std::move(stack_.back().key);
+    stack_.pop_back();
+    next() = std::move(v);
+    return true;
+  }
+
+private:
+  struct frame {
+    json::type type;
+    std::size_t index;
+    std::string key;
+    bool numbers = true;  // every element is a number that is exact as a double
+  };
+
+  // Returns a reference to the value that should receive the next event.
+  value& next(bool number = false)
+  {
+    if (stack_.empty()) {
+      return root_;
+    }
+    if (!number) {
+      stack_.back().numbers = false;
+    }
+    if (stack_.back().type == type::array) {
+      elements_.emplace_back(value());
+    } else {
+      elements_.emplace_back(keys_ ? keys_->intern(key_) : json::name(std::move(key_), allocator_), value());
+    }
+    return elements_.back().value;
+  }
+
+  value& root_;
+  json::allocator<element<value>> allocator_;
+  json::keys* keys_;
+  bool views_;
+  std::vector<frame> stack_;
+  std::vector<element<value>> elements_;
+  std::string key_;
+};
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
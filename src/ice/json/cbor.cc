@@ -0,0 +1,318 @@
+#include <ice/json/cbor.h>
+#include <ice/json/binary.h>
+#include <ice/json/builder.h>
+#include <limits>
+
+namespace ice {
+namespace json {
+namespace cbor {
+namespace {
+
+enum major_type : std::uint8_t {
+  unsigned_integer = 0,
+  negative_integer = 1,
+  byte_string = 2,
+  text_string = 3,
+  array_type = 4,
+  map_type = 5,
+  tag = 6,
+  simple = 7,
+};
+
+constexpr std::uint8_t indefinite = 31;
+constexpr std::uint8_t break_code = 0xFF;
+
+// Appends the initial byte and the argument in the shortest form.
+void encode_head(buffer& out, major_type major, std::uint64_t argument)
+{
+  auto initial = static_cast<std::uint8_t>(major << 5);
+  if (argument < 24) {
+    out.append(static_cast<char>(initial | argument));
+  } else if (argument <= 0xFF) {
+    out.append(static_cast<char>(initial | 24));
+    detail::append_be(out, argument, 1);
+  } else if (argument <= 0xFFFF) {
+    out.append(static_cast<char>(initial | 25));
+    detail::append_be(out, argument, 2);
+  } else if (argument <= 0xFFFFFFFF) {
+    out.append(static_cast<char>(initial | 26));
+    detail::append_be(out, argument, 4);
+  } else {
+    out.append(static_cast<char>(initial | 27));
+    detail::append_be(out, argument, 8);
+  }
+}
+
+void encode_number(buffer& out, const value& v)
+{
+  std::int64_t i = 0;
+  if (detail::to_integer(v, i)) {
+    if (i >= 0) {
+      encode_head(out, unsigned_integer, static_cast<std::uint64_t>(i));
+    } else {
+      encode_head(out, negative_integer, static_cast<std::uint64_t>(-(i + 1)));
+    }
+    return;
+  }
+  auto n = v.as_number();
+  if (detail::is_float(n)) {
+    out.append('\xFA');
+    detail::append_be(out, detail::float_bits(static_cast<float>(n)), 4);
+  } else {
+    out.append('\xFB');
+    detail::append_be(out, detail::double_bits(n), 8);
+  }
+}
+
+void encode_string(buffer& out, ice::string_view v)
+{
+  encode_head(out, text_string, v.size());
+  out.append(v.data(), v.size());
+}
+
+void encode_value(buffer& out, const value& v)
+{
+  switch (v.type()) {
+  case type::null: out.append('\xF6'); return;
+  case type::boolean: out.append(v.as_boolean() ? '\xF5' : '\xF4'); return;
+  case type::number: encode_number(out, v); return;
+  case type::string: encode_string(out, v.as<ice::string_view>()); return;
+  case type::array:
+    encode_head(out, array_type, v.size());
+    if (v.is<numbers>()) {
+      for (auto n : v.data<numbers>()) {
+        encode_number(out, value(n));
+      }
+      return;
+    }
+    for (const auto& e : v) {
+      encode_value(out, e.value);
+    }
+    return;
+  case type::object:
+    encode_head(out, map_type, v.size());
+    for (const auto& e : v) {
+      encode_string(out, e.name.value());
+      encode_value(out, e.value);
+    }
+    return;
+  }
+}
+
+// Converts an IEEE 754 half precision float.
+double half_to_double(std::uint16_t half) noexcept
+{
+  auto exponent = (half >> 10) & 0x1F;
+  auto mantissa = half & 0x3FF;
+  double v = 0;
+  if (exponent == 0) {
+    v = std::ldexp(mantissa, -24);
+  } else if (exponent != 31) {
+    v = std::ldexp(mantissa + 1024, exponent - 25);
+  } else if (mantissa == 0) {
+    v = std::numeric_limits<double>::infinity();
+  } else {
+    v = std::numeric_limits<double>::quiet_NaN();
+  }
+  return half & 0x8000 ? -v : v;
+}
+
+// Decodes CBOR data items and reports them to the builder.
+template <typename Source>
+class decoder {
+public:
+  decoder(Source& source, detail::builder& handler) noexcept : source_(source), handler_(handler)
+  {}
+
+  void decode(std::size_t depth = 0)
+  {
+    if (depth == detail::max_binary_depth) {
+      throw source_.error("maximum nesting depth exceeded");
+    }
+    auto initial = source_.next();
+    auto major = static_cast<major_type>(initial >> 5);
+    auto info = static_cast<std::uint8_t>(initial & 0x1F);
+    switch (major) {
+    case unsigned_integer:
+    {
+      auto n = argument(info);
+      if (n <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+        handler_.on_integer(static_cast<std::int64_t>(n));
+      } else {
+        handler_.on_number(static_cast<double>(n));
+      }
+    } break;
+    case negative_integer:
+    {
+      auto n = argument(info);
+      if (n <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+        handler_.on_integer(-1 - static_cast<std::int64_t>(n));
+      } else {
+        handler_.on_number(-1.0 - static_cast<double>(n));
+      }
+    } break;
+    case byte_string:
+    case text_string: handler_.on_string(read_string(major, info)); break;
+    case array_type:
+      handler_.on_start_array();
+      if (info == indefinite) {
+        while (source_.peek() != break_code) {
+          decode(depth + 1);
+        }
+        source_.next();
+      } else {
+        for (auto size = argument(info); size > 0; size--) {
+          decode(depth + 1);
+        }
+      }
+      handler_.on_end_array();
+      break;
+    case map_type:
+      handler_.on_start_object();
+      if (info == indefinite) {
+        while (source_.peek() != break_code) {
+          decode_element(depth);
+        }
+        source_.next();
+      } else {
+        for (auto size = argument(info); size > 0; size--) {
+          decode_element(depth);
+        }
+      }
+      handler_.on_end_object();
+      break;
+    case tag:
+      argument(info);
+      decode(depth + 1);
+      break;
+    case simple: decode_simple(info); break;
+    }
+  }
+
+private:
+  std::uint64_t argument(std::uint8_t info)
+  {
+    if (info < 24) {
+      return info;
+    }
+    if (info > 27) {
+      throw source_.error("invalid argument");
+    }
+    return source_.read(std::size_t(1) << (info - 24));
+  }
+
+  void decode_element(std::size_t depth)
+  {
+    auto initial = source_.next();
+    if (initial >> 5 != text_string) {
+      throw source_.error("unsupported map key");
+    }
+    handler_.on_key(read_string(text_string, initial & 0x1F));
+    decode(depth + 1);
+  }
+
+  void decode_simple(std::uint8_t info)
+  {
+    switch (info) {
+    case 20: handler_.on_boolean(false); break;
+    case 21: handler_.on_boolean(true); break;
+    case 22:
+    case 23: handler_.on_null(); break;
+    case 25: handler_.on_number(half_to_double(static_cast<std::uint16_t>(source_.read(2)))); break;
+    case 26:
+    {
+      auto bits = static_cast<std::uint32_t>(source_.read(4));
+      float v = 0;
+      std::memcpy(&v, &bits, sizeof(v));
+      handler_.on_number(v);
+    } break;
+    case 27:
+    {
+      auto bits = source_.read(8);
+      double v = 0;
+      std::memcpy(&v, &bits, sizeof(v));
+      handler_.on_number(v);
+    } break;
+    case indefinite: throw source_.error("unexpected break");
+    default: throw source_.error("unsupported simple value");
+    }
+  }
+
+  // Reads a byte or text string. Indefinite length strings are concatenated from their chunks.
+  ice::string_view read_string(major_type major, std::uint8_t info)
+  {
+    if (info != indefinite) {
+      return detail::check_utf8(source_, source_.read_string(argument(info)));
+    }
+    string_.clear();
+    while (source_.peek() != break_code) {
+      auto initial = source_.next();
+      if (initial >> 5 != major || (initial & 0x1F) == indefinite) {
+        throw source_.error("invalid string chunk");
+      }
+      auto chunk = source_.read_string(argument(initial & 0x1F));
+      string_.append(chunk.data(), chunk.size());
+    }
+    source_.next();
+    return detail::check_utf8(source_, string_);
+  }
+
+  Source& source_;
+  detail::builder& handler_;
+  std::string string_;
+};
+
+template <typename Source>
+value decode(Source& source)
+{
+  value root;
+  detail::builder handler(root);
+  decoder<Source>(source, handler).decode();
+  return root;
+}
+
+}  // namespace
+
+std::string encode(const value& root)
+{
+  buffer out;
+  encode_value(out, root);
+  return out.release();
+}
+
+std::ostream& encode(std::ostream& os, const value& root)
+{
+  char data[4096];
+  buffer out(data, sizeof(data), [&os](const char* s, std::size_t size) {
+    os.write(s, static_cast<std::streamsize>(size));
+  });
+  encode_value(out, root);
+  out.flush();
+  return os;
+}
+
+void encode(buffer& out, const value& root)
+{
+  encode_value(out, root);
+}
+
+value decode(std::istream& is)
+{
+  detail::stream_source source(is);
+  return decode(source);
+}
+
+value decode(const std::string& data)
+{
+  return decode(data.data(), data.size());
+}
+
+value decode(const char* data, std::size_t size)
+{
+  detail::buffer_source source(data, size);
+  return decode(source);
+}
+
+}  // namespace cbor
+}  // namespace json
+}  // namespace ice
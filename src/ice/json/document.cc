@@ -0,0 +1,89 @@
+#include <ice/json/document.h>
+#include <ice/json/builder.h>
+#include <ice/json/reader.h>
+
+namespace ice {
+namespace json {
+
+document::document(std::size_t block_size) : arena_(block_size)
+{}
+
+value& document::parse(const std::string& text)
+{
+  return parse(text.data(), text.size());
+}
+
+value& document::parse(const char* text, std::size_t size)
+{
+  clear();
+  if (!text) {
+    return root_;
+  }
+  try {
+    detail::builder handler(root_, get_allocator());
+    detail::read(text, size, handler);
+  }
+  catch (...) {
+    clear();
+    throw;
+  }
+  return root_;
+}
+
+value& document::parse(std::string&& text)
+{
+  clear();
+  text_ = std::move(text);
+  return parse_in_situ(&text_[0], text_.size());
+}
+
+value& document::parse(std::vector<char>&& text)
+{
+  clear();
+  data_ = std::move(text);
+  return parse_in_situ(data_.data(), data_.size());
+}
+
+value& document::root() noexcept
+{
+  return root_;
+}
+
+const value& document::root() const noexcept
+{
+  return root_;
+}
+
+json::allocator<element<value>> document::get_allocator() noexcept
+{
+  return &arena_;
+}
+
+void document::clear() noexcept
+{
+  root_.reset();
+  arena_.clear();
+  text_ = std::string();
+  data_ = std::vector<char>();
+}
+
+value& document::parse_in_situ(char* text, std::size_t size)
+{
+  try {
+    detail::builder handler(root_, get_allocator(), nullptr, true);
+    detail::read(text, size, handler, detail::in_situ);
+  }
+  catch (...) {
+    clear();
+    throw;
+  }
+  return root_;
+}
+
+std::ostream& operator<<(std::ostream& os, const document& doc)
+{
+  return os << doc.root();
+}
+
+}  // namespace json
+}  // namespace ice
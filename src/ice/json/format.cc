@@ -1,7 +1,18 @@
 #include <ice/json/format.h>
+#include <ice/json/number.h>
+#include <ice/json/output.h>
+#include <ice/json/traits.h>
 #include <ice/utf8.h>
-#include <iomanip>
-#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ICE_JSON_FORMAT_X86 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace ice {
 namespace json {
@@ -30,140 +41,337 @@ inline char utf16_hex_char(unsigned char c)
   return '0';
 }
 
-inline std::ostream& format(std::ostream& os, const string& v)
+// Characters that are copied to the output without escaping or UTF-8 validation.
+struct plain_table {
+  bool data[256];
+
+  constexpr plain_table() : data()
+  {
+    for (int i = 0x20; i < 0x7F; i++) {
+      data[i] = i != '"' && i != '\\';
+    }
+  }
+};
+
+constexpr plain_table plain_chars;
+
+inline bool is_plain(char c)
 {
-  for (auto it = v.begin(); it != v.end(); ++it) {
-    char c = *it;
+  return plain_chars.data[static_cast<unsigned char>(c)];
+}
+
+#ifdef ICE_JSON_FORMAT_X86
+
+// Returns a mask of the bytes that are not plain characters.
+inline int special_mask(__m128i v)
+{
+  // Control characters and bytes with the high bit set are both less than ' ' as signed integers.
+  auto special = _mm_cmplt_epi8(v, _mm_set1_epi8(0x20));
+  special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+  special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+  special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F)));
+  return _mm_movemask_epi8(special);
+}
+
+inline int first_bit(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+#endif
+
+// Returns the first character that needs to be escaped or validated.
+// Scans 32 bytes per iteration with SSE2, which is part of the x86-64 baseline.
+inline const char* find_special(const char* it, const char* end)
+{
+#ifdef ICE_JSON_FORMAT_X86
+  while (end - it >= 32) {
+    auto lo = special_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)));
+    auto hi = special_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 16)));
+    auto mask = static_cast<unsigned int>(lo) | static_cast<unsigned int>(hi) << 16;
+    if (mask != 0) {
+      return it + first_bit(mask);
+    }
+    it += 32;
+  }
+  if (end - it >= 16) {
+    auto mask = static_cast<unsigned int>(special_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it))));
+    if (mask != 0) {
+      return it + first_bit(mask);
+    }
+    it += 16;
+  }
+#endif
+  while (it != end && is_plain(*it)) {
+    ++it;
+  }
+  return it;
+}
+
+inline bool is_continuation(const char* it, const char* end)
+{
+  return it != end && (*it & 0xC0) == 0x80;
+}
+
+// Validates UTF-8 sequences starting at a byte with the high bit set and returns the next character that needs to be
+// escaped or validated. Multi-byte sequences usually come in groups, so the scalar loop continues until a run of plain
+// characters is long enough for the vector scan.
+const char* skip_utf8(const char* it, const char* end)
+{
+  std::size_t plain = 0;
+  while (it != end && plain < 16) {
+    auto c = *it;
     if ((c & 0x80) == 0) {
-      switch (c) {
-      case '"': os << "\\\""; break;
-      case '\\': os << "\\\\"; break;
-      case '\b': os << "\\b"; break;
-      case '\f': os << "\\f"; break;
-      case '\n': os << "\\n"; break;
-      case '\r': os << "\\r"; break;
-      case '\t': os << "\\t"; break;
-      default:
-        if (c < 0x20 || c == 0x7F || (static_cast<unsigned char>(c) >= 0x80 && static_cast<unsigned char>(c) <= 0x9F)) {
-          os << "\\u00" << utf16_hex_char(static_cast<unsigned char>(c) >> 4)
-            << utf16_hex_char(static_cast<unsigned char>(c));
-        } else {
-          os << c;
-        }
+      if (!is_plain(c)) {
         break;
       }
-    } else if ((c & 0xE0) == 0xC0) {
       ++it;
-      if (it == v.end() || ((*it) & 0xC0) != 0x80) {
-        throw std::runtime_error("invalid UTF-8");
-      }
-      os << c << *it;
+      ++plain;
+      continue;
+    }
+    std::size_t size = 0;
+    if ((c & 0xE0) == 0xC0) {
+      size = 2;
     } else if ((c & 0xF0) == 0xE0) {
-      ++it;
-      if (it == v.end() || ((*it) & 0xC0) != 0x80) {
-        throw std::runtime_error("invalid UTF-8");
-      }
-      char c2 = *it;
-      ++it;
-      if (it == v.end() || ((*it) & 0xC0) != 0x80) {
-        throw std::runtime_error("invalid UTF-8");
-      }
-      os << c << c2 << *it;
+      size = 3;
     } else if ((c & 0xF8) == 0xF0) {
-      ++it;
-      if (it == v.end() || ((*it) & 0xC0) != 0x80) {
-        throw std::runtime_error("invalid UTF-8");
-      }
-      char c2 = *it;
-      ++it;
-      if (it == v.end() || ((*it) & 0xC0) != 0x80) {
-        throw std::runtime_error("invalid UTF-8");
-      }
-      char c3 = *it;
-      ++it;
-      if (it == v.end() || ((*it) & 0xC0) != 0x80) {
-        throw std::runtime_error("invalid UTF-8");
-      }
-      os << c << c2 << c3 << *it;
+      size = 4;
     } else {
       throw std::runtime_error("invalid UTF-8");
     }
+    for (std::size_t i = 1; i < size; i++) {
+      if (!is_continuation(it + i, end)) {
+        throw std::runtime_error("invalid UTF-8");
+      }
+    }
+    it += size;
+    plain = 0;
   }
-  return os;
+  return it;
+}
+
+void format(buffer& out, const array& v, bool pretty, std::size_t offset)
+{
+  if (v.empty()) {
+    out.append("[]", 2);
+    return;
+  }
+  out.append('[');
+  for (auto it = v.begin(); it != v.end(); ++it) {
+    if (it != v.begin()) {
+      out.append(',');
+    }
+    if (pretty) {
+      detail::indent(out, offset + 2);
+    }
+    format(out, it->value, pretty, offset + 2);
+  }
+  if (pretty) {
+    detail::indent(out, offset);
+  }
+  out.append(']');
 }
 
-inline std::ostream& format(std::ostream& os, const array& v, bool pretty, std::size_t offset)
+void format(buffer& out, const numbers& v, bool pretty, std::size_t offset)
 {
   if (v.empty()) {
-    return os << "[]";
+    out.append("[]", 2);
+    return;
   }
-  os << '[';
+  out.append('[');
+  char chars[detail::max_number_size];
   for (auto it = v.begin(); it != v.end(); ++it) {
     if (it != v.begin()) {
-      os << ',';
+      out.append(',');
     }
     if (pretty) {
-      os << '\n' << std::string(offset + 2, ' ');
+      detail::indent(out, offset + 2);
     }
-    format(os, it->value, pretty, offset + 2);
+    auto end = detail::to_chars(chars, *it);
+    out.append(chars, static_cast<std::size_t>(end - chars));
   }
   if (pretty) {
-    os << '\n' << std::string(offset, ' ');
+    detail::indent(out, offset);
   }
-  return os << ']';
+  out.append(']');
 }
 
-inline std::ostream& format(std::ostream& os, const object& v, bool pretty, std::size_t offset)
+void format(buffer& out, const object& v, bool pretty, std::size_t offset)
 {
   if (v.empty()) {
-    return os << "{}";
+    out.append("{}", 2);
+    return;
   }
-  os << '{';
+  out.append('{');
   for (auto it = v.begin(); it != v.end(); ++it) {
     if (it != v.begin()) {
-      os << ',';
+      out.append(',');
     }
     if (pretty) {
-      os << '\n' << std::string(offset + 2, ' ');
+      detail::indent(out, offset + 2);
     }
-    os << '"';
-    format(os, it->name.value());
-    os << "\":";
+    out.append('"');
+    const auto& name = it->name.value();
+    detail::escape(out, name.data(), name.size());
     if (pretty) {
-      os << ' ';
+      out.append("\": ", 3);
+    } else {
+      out.append("\":", 2);
     }
-    format(os, it->value, pretty, offset + 2);
+    format(out, it->value, pretty, offset + 2);
   }
   if (pretty) {
-    os << '\n' << std::string(offset, ' ');
+    detail::indent(out, offset);
+  }
+  out.append('}');
+}
+
+// Estimates the serialized size of a json value without escape sequences.
+std::size_t estimate(const value& v, bool pretty, std::size_t offset)
+{
+  if (v.is<numbers>()) {
+    return 2 + v.size() * (pretty ? offset + 12 : 9);
+  }
+  switch (v.type()) {
+  case type::string: return v.as<ice::string_view>().size() + 2;
+  case type::array:
+  case type::object:
+  {
+    std::size_t size = 2;
+    for (const auto& e : v) {
+      size += estimate(e.value, pretty, offset + 2) + 1;
+      if (e.name) {
+        size += e.name->size() + 4;
+      }
+      if (pretty) {
+        size += offset + 3;
+      }
+    }
+    return size;
+  }
+  default: return 8;
   }
-  return os << '}';
 }
 
 }  // namespace
 
+namespace detail {
+
+// Runs of plain characters and valid UTF-8 sequences are appended at once when the next escape sequence is reached.
+void escape(buffer& out, const char* data, std::size_t size)
+{
+  auto it = data;
+  auto end = data + size;
+  auto run = it;
+  while (true) {
+    it = find_special(it, end);
+    if (it == end) {
+      break;
+    }
+    char c = *it;
+    if ((c & 0x80) != 0) {
+      it = skip_utf8(it, end);
+      continue;
+    }
+    if (it != run) {
+      out.append(run, static_cast<std::size_t>(it - run));
+    }
+    switch (c) {
+    case '"': out.append("\\\"", 2); break;
+    case '\\': out.append("\\\\", 2); break;
+    case '\b': out.append("\\b", 2); break;
+    case '\f': out.append("\\f", 2); break;
+    case '\n': out.append("\\n", 2); break;
+    case '\r': out.append("\\r", 2); break;
+    case '\t': out.append("\\t", 2); break;
+    default:
+    {
+      const char sequence[] = { '\\', 'u', '0', '0', utf16_hex_char(static_cast<unsigned char>(c) >> 4),
+        utf16_hex_char(static_cast<unsigned char>(c)) };
+      out.append(sequence, sizeof(sequence));
+    } break;
+    }
+    run = ++it;
+  }
+  if (it != run) {
+    out.append(run, static_cast<std::size_t>(it - run));
+  }
+}
+
+void indent(buffer& out, std::size_t offset)
+{
+  static const char line[] = "\n                                                               ";
+  if (offset < sizeof(line) - 1) {
+    out.append(line, offset + 1);
+  } else {
+    out.append('\n');
+    out.append(offset, ' ');
+  }
+}
+
+}  // namespace detail
+
 std::string format(const value& root, bool pretty)
 {
-  std::ostringstream oss;
-  format(oss, root, pretty);
-  return oss.str();
+  buffer out;
+  out.reserve(estimate(root, pretty, 0));
+  format(out, root, pretty);
+  return out.release();
+}
+
+std::ostream& format(std::ostream& os, const value& root, bool pretty, std::size_t offset)
+{
+  char data[4096];
+  buffer out(data, sizeof(data), [&os](const char* s, std::size_t size) {
+    os.write(s, static_cast<std::streamsize>(size));
+  });
+  format(out, root, pretty, offset);
+  out.flush();
+  return os;
 }
 
-std::ostream& format(std::ostream& os, const json::value& v, bool pretty, std::size_t offset)
+void format(buffer& out, const value& v, bool pretty, std::size_t offset)
 {
   switch (v.type_) {
-  case type::null: return os << "null";
-  case type::boolean: return os << (v.data_.boolean ? "true" : "false");
-  case type::number: return os << v.data_.number;
+  case type::null: out.append("null", 4); return;
+  case type::boolean:
+    if (v.data_.boolean) {
+      out.append("true", 4);
+    } else {
+      out.append("false", 5);
+    }
+    return;
+  case type::number:
+  {
+    char chars[detail::max_number_size];
+    auto end = (v.flags_ & value::integer_flag) ? detail::to_chars(chars, v.as_integer()) : detail::to_chars(chars, v.data_.number);
+    out.append(chars, static_cast<std::size_t>(end - chars));
+  }
+    return;
   case type::string:
-    os << '"';
-    format(os, v.data_.string);
-    return os << '"';
-  case type::array: return format(os, v.data_.array, pretty, offset);
-  case type::object: return format(os, v.data_.object, pretty, offset);
+  {
+    auto text = v.text();
+    out.append('"');
+    detail::escape(out, text.data(), text.size());
+    out.append('"');
+  }
+    return;
+  case type::array:
+    if (v.flags_ & value::packed_flag) {
+      format(out, *v.data_.numbers, pretty, offset);
+    } else {
+      format(out, *v.data_.array, pretty, offset);
+    }
+    return;
+  case type::object: format(out, *v.data_.object, pretty, offset); return;
   }
-  return os;
 }
 
 }  // namespace json
-}  // namespace ice
\ No newline at end of file
+}  // namespace ice
@@ -0,0 +1,190 @@
+#include <ice/json/hash.h>
+#include <ice/json/traits.h>
+#include <ice/string_view.h>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace ice {
+namespace json {
+namespace {
+
+// Doubles at or beyond 2^63 do not fit into a 64-bit integer.
+constexpr number max_integer = 9223372036854775808.0;
+
+// Mixes the bits of a 64-bit value (splitmix64 finalizer).
+inline std::uint64_t mix(std::uint64_t h) noexcept
+{
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EB;
+  h ^= h >> 31;
+  return h;
+}
+
+// Combines a hash with the hash of the next element. The result depends on the order of the elements.
+inline std::uint64_t combine(std::uint64_t seed, std::uint64_t h) noexcept
+{
+  return mix(seed ^ (h + 0x9E3779B97F4A7C15 + (seed << 6) + (seed >> 2)));
+}
+
+inline std::uint64_t hash_integer(std::int64_t v) noexcept
+{
+  return mix(static_cast<std::uint64_t>(v));
+}
+
+// Hashes integral numbers that fit into a 64-bit integer like that integer, so that a number has the same hash whether
+// the json value keeps an exact integer or not. Other numbers, including 2^63, are hashed by their bits.
+inline std::uint64_t hash_number(number v) noexcept
+{
+  if (std::trunc(v) == v && v >= -max_integer && v < max_integer) {
+    return hash_integer(static_cast<std::int64_t>(v));
+  }
+  std::uint64_t bits = 0;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return mix(bits);
+}
+
+// Hashes the string 8 bytes at a time.
+inline std::uint64_t hash_string(ice::string_view v) noexcept
+{
+  std::uint64_t h = v.size();
+  auto data = v.data();
+  auto size = v.size();
+  for (; size >= 8; data += 8, size -= 8) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, data, 8);
+    h = combine(h, word);
+  }
+  if (size) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, data, size);
+    h = combine(h, word);
+  }
+  return h;
+}
+
+std::uint64_t hash_value(const value& v, bool canonical)
+{
+  auto type = v.type();
+  auto seed = static_cast<std::uint64_t>(type) + 1;
+  switch (type) {
+  case json::type::null: return mix(seed);
+  case json::type::boolean: return combine(seed, v.data<boolean>() ? 1 : 0);
+  case json::type::number:
+    if (v.has_integer()) {
+      return combine(seed, hash_integer(v.as_integer()));
+    }
+    return combine(seed, hash_number(v.data<number>()));
+  case json::type::string: return combine(seed, hash_string(v.as<ice::string_view>()));
+  case json::type::array:
+  {
+    auto h = combine(seed, v.size());
+    if (v.is<numbers>()) {
+      for (auto n : v.data<numbers>()) {
+        h = combine(h, combine(static_cast<std::uint64_t>(json::type::number) + 1, hash_number(n)));
+      }
+    } else {
+      for (const auto& e : v.data<array>()) {
+        h = combine(h, hash_value(e.value, canonical));
+      }
+    }
+    return h;
+  }
+  case json::type::object:
+  {
+    auto h = combine(seed, v.size());
+    if (canonical) {
+      // The sum of the element hashes does not depend on their order.
+      std::uint64_t sum = 0;
+      for (const auto& e : v.data<object>()) {
+        sum += combine(hash_string(*e.name), hash_value(e.value, canonical));
+      }
+      return combine(h, sum);
+    }
+    for (const auto& e : v.data<object>()) {
+      h = combine(combine(h, hash_string(*e.name)), hash_value(e.value, canonical));
+    }
+    return h;
+  }
+  }
+  return seed;
+}
+
+// Returns the object elements sorted by name.
+std::vector<const element<value>*> sorted(const object& o)
+{
+  std::vector<const element<value>*> elements;
+  elements.reserve(o.size());
+  for (const auto& e : o) {
+    elements.push_back(&e);
+  }
+  std::stable_sort(elements.begin(), elements.end(), [](const auto* a, const auto* b) { return a->name < b->name; });
+  return elements;
+}
+
+// Compares json values and ignores the order of object elements.
+bool equal_canonical(const value& a, const value& b)
+{
+  if (a.type() != b.type()) {
+    return false;
+  }
+  switch (a.type()) {
+  case json::type::array:
+  {
+    // Arrays stored as 'ice::json::numbers' cannot contain objects.
+    if (a.is<numbers>() || b.is<numbers>()) {
+      return a == b;
+    }
+    const auto& x = a.data<array>();
+    const auto& y = b.data<array>();
+    if (x.size() != y.size()) {
+      return false;
+    }
+    for (std::size_t i = 0, size = x.size(); i < size; i++) {
+      if (!equal_canonical(x[i].value, y[i].value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  case json::type::object:
+  {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    auto x = sorted(a.data<object>());
+    auto y = sorted(b.data<object>());
+    for (std::size_t i = 0, size = x.size(); i < size; i++) {
+      if (x[i]->name != y[i]->name || !equal_canonical(x[i]->value, y[i]->value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  default: return a == b;
+  }
+}
+
+}  // namespace
+
+std::size_t hash(const value& v, bool canonical)
+{
+  return static_cast<std::size_t>(hash_value(v, canonical));
+}
+
+bool equal(const value& a, const value& b, bool canonical)
+{
+  return canonical ? equal_canonical(a, b) : a == b;
+}
+
+bool operator==(const hashed& a, const hashed& b)
+{
+  return a.canonical() == b.canonical() && a.hash() == b.hash() && equal(a.get(), b.get(), a.canonical());
+}
+
+}  // namespace json
+}  // namespace ice
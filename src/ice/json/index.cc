@@ -0,0 +1,348 @@
+#include <ice/json/index.h>
+#include <limits>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ICE_JSON_INDEX_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ICE_JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ICE_JSON_TARGET_AVX2
+#endif
+
+namespace ice {
+namespace json {
+namespace detail {
+namespace {
+
+// Number of bytes that are indexed at once. Must be a multiple of 64.
+// The positions buffer for a chunk fits into the L2 cache together with the chunk itself.
+constexpr std::size_t chunk_size = 16 * 1024;
+
+// Character masks of a 64 byte block. Bit N represents byte N.
+struct block {
+  std::uint64_t quote = 0;
+  std::uint64_t backslash = 0;
+  std::uint64_t structural = 0;
+  std::uint64_t space = 0;
+  std::uint64_t slash = 0;
+  std::uint64_t high = 0;
+};
+
+#ifdef ICE_JSON_INDEX_X86
+
+inline std::uint64_t mask_sse2(__m128i v)
+{
+  return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(v)));
+}
+
+// SSE2 is part of the x86-64 baseline and does not require a runtime check.
+void classify_sse2(const char* data, block& b)
+{
+  const auto quote = _mm_set1_epi8('"');
+  const auto backslash = _mm_set1_epi8('\\');
+  const auto open = _mm_set1_epi8('{');
+  const auto close = _mm_set1_epi8('}');
+  const auto case_bit = _mm_set1_epi8(0x20);
+  const auto colon = _mm_set1_epi8(':');
+  const auto comma = _mm_set1_epi8(',');
+  const auto space = _mm_set1_epi8(' ');
+  const auto tab = _mm_set1_epi8('\t');
+  const auto range = _mm_set1_epi8(4);
+  const auto slash = _mm_set1_epi8('/');
+  for (auto i = 0; i < 4; i++) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+    auto shift = i * 16;
+    // Setting the 0x20 bit maps '[' and ']' to '{' and '}'.
+    auto folded = _mm_or_si128(v, case_bit);
+    auto structural = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+      _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+    // Characters '\t' to '\r' are in the unsigned range [0x09, 0x0D].
+    auto control = _mm_sub_epi8(v, tab);
+    auto whitespace = _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(_mm_min_epu8(control, range), control));
+    b.quote |= mask_sse2(_mm_cmpeq_epi8(v, quote)) << shift;
+    b.backslash |= mask_sse2(_mm_cmpeq_epi8(v, backslash)) << shift;
+    b.structural |= mask_sse2(structural) << shift;
+    b.space |= mask_sse2(whitespace) << shift;
+    b.slash |= mask_sse2(_mm_cmpeq_epi8(v, slash)) << shift;
+    b.high |= mask_sse2(v) << shift;
+  }
+}
+
+ICE_JSON_TARGET_AVX2 inline std::uint64_t mask_avx2(__m256i v)
+{
+  return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(v)));
+}
+
+ICE_JSON_TARGET_AVX2 void classify_avx2(const char* data, block& b)
+{
+  const auto quote = _mm256_set1_epi8('"');
+  const auto backslash = _mm256_set1_epi8('\\');
+  const auto open = _mm256_set1_epi8('{');
+  const auto close = _mm256_set1_epi8('}');
+  const auto case_bit = _mm256_set1_epi8(0x20);
+  const auto colon = _mm256_set1_epi8(':');
+  const auto comma = _mm256_set1_epi8(',');
+  const auto space = _mm256_set1_epi8(' ');
+  const auto tab = _mm256_set1_epi8('\t');
+  const auto range = _mm256_set1_epi8(4);
+  const auto slash = _mm256_set1_epi8('/');
+  for (auto i = 0; i < 2; i++) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 32));
+    auto shift = i * 32;
+    auto folded = _mm256_or_si256(v, case_bit);
+    auto structural = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+    auto control = _mm256_sub_epi8(v, tab);
+    auto whitespace =
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(_mm256_min_epu8(control, range), control));
+    b.quote |= mask_avx2(_mm256_cmpeq_epi8(v, quote)) << shift;
+    b.backslash |= mask_avx2(_mm256_cmpeq_epi8(v, backslash)) << shift;
+    b.structural |= mask_avx2(structural) << shift;
+    b.space |= mask_avx2(whitespace) << shift;
+    b.slash |= mask_avx2(_mm256_cmpeq_epi8(v, slash)) << shift;
+    b.high |= mask_avx2(v) << shift;
+  }
+}
+
+bool has_avx2()
+{
+#ifdef _MSC_VER
+  int info[4] = {};
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  // The processor and the operating system must support AVX (OSXSAVE, AVX and the YMM state in XCR0).
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#else
+
+enum : std::uint8_t {
+  class_quote = 0x01,
+  class_backslash = 0x02,
+  class_structural = 0x04,
+  class_space = 0x08,
+  class_slash = 0x10,
+  class_high = 0x20,
+};
+
+struct class_table {
+  std::uint8_t data[256];
+
+  constexpr class_table() : data()
+  {
+    for (int i = 0; i < 256; i++) {
+      std::uint8_t flags = 0;
+      switch (i) {
+      case '"': flags = class_quote; break;
+      case '\\': flags = class_backslash; break;
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',': flags = class_structural; break;
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+      case '\v':
+      case '\f': flags = class_space; break;
+      case '/': flags = class_slash; break;
+      }
+      if (i >= 0x80) {
+        flags = class_high;
+      }
+      data[i] = flags;
+    }
+  }
+};
+
+constexpr class_table class_flags;
+
+void classify_scalar(const char* data, block& b)
+{
+  for (std::size_t i = 0; i < 64; i++) {
+    auto flags = class_flags.data[static_cast<unsigned char>(data[i])];
+    auto bit = std::uint64_t(1) << i;
+    if (flags & class_quote) {
+      b.quote |= bit;
+    }
+    if (flags & class_backslash) {
+      b.backslash |= bit;
+    }
+    if (flags & class_structural) {
+      b.structural |= bit;
+    }
+    if (flags & class_space) {
+      b.space |= bit;
+    }
+    if (flags & class_slash) {
+      b.slash |= bit;
+    }
+    if (flags & class_high) {
+      b.high |= bit;
+    }
+  }
+}
+
+#endif
+
+using classify_function = void (*)(const char* data, block& b);
+
+classify_function select_classify()
+{
+#ifdef ICE_JSON_INDEX_X86
+  return has_avx2() ? classify_avx2 : classify_sse2;
+#else
+  return classify_scalar;
+#endif
+}
+
+inline std::uint64_t prefix_xor(std::uint64_t v)
+{
+  v ^= v << 1;
+  v ^= v << 2;
+  v ^= v << 4;
+  v ^= v << 8;
+  v ^= v << 16;
+  v ^= v << 32;
+  return v;
+}
+
+inline unsigned trailing_zeros(std::uint64_t v)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index = 0;
+  _BitScanForward64(&index, v);
+  return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+  unsigned long index = 0;
+  if (_BitScanForward(&index, static_cast<unsigned long>(v))) {
+    return static_cast<unsigned>(index);
+  }
+  _BitScanForward(&index, static_cast<unsigned long>(v >> 32));
+  return static_cast<unsigned>(index) + 32;
+#else
+  return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
+
+// Returns the mask of characters that are escaped by an odd number of preceding backslashes.
+// The carry is set when the block ends with an unfinished escape sequence.
+inline std::uint64_t escaped(std::uint64_t backslash, std::uint64_t& carry)
+{
+  const std::uint64_t even_bits = 0x5555555555555555ULL;
+  // A backslash that is escaped itself does not start a new escape sequence.
+  backslash &= ~carry;
+  auto follows_escape = (backslash << 1) | carry;
+  auto odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+  auto sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+  carry = sequences_starting_on_even_bits < backslash ? 1 : 0;
+  auto invert_mask = sequences_starting_on_even_bits << 1;
+  return (even_bits ^ invert_mask) & follows_escape;
+}
+
+}  // namespace
+
+structural_index::structural_index(const char* data, std::size_t size) :
+  data_(data), size_(size), positions_(chunk_size + 64), dirty_((size + 63) / 64 + 1, 0)
+{}
+
+bool structural_index::supported(std::size_t size)
+{
+  return size < std::numeric_limits<std::uint32_t>::max();
+}
+
+bool structural_index::fill()
+{
+  static const auto classify = select_classify();
+
+  std::size_t count = 0;
+  char tail[64];
+
+  while (count == 0 && offset_ < size_) {
+    auto chunk_end = offset_ + chunk_size < size_ ? offset_ + chunk_size : size_;
+    auto out = positions_.data();
+    for (; offset_ < chunk_end; offset_ += 64) {
+      auto src = data_ + offset_;
+      auto size = size_ - offset_;
+      if (size < 64) {
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, src, size);
+        src = tail;
+      }
+
+      block b;
+      classify(src, b);
+
+      // The UTF-8 byte order mark is treated as whitespace.
+      if (offset_ == 0 && size >= 3 && src[0] == '\xEF' && src[1] == '\xBB' && src[2] == '\xBF') {
+        b.high &= ~std::uint64_t(0x7);
+        b.space |= 0x7;
+      }
+
+      // Quotes escaped by an odd number of backslashes are part of the string.
+      auto quote = b.quote & ~escaped(b.backslash, escape_carry_);
+
+      // Bits between an opening quote (inclusive) and a closing quote (exclusive).
+      auto in_string = prefix_xor(quote) ^ string_carry_;
+      string_carry_ = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+
+      // Comments are not supported by the structural index.
+      if (b.slash & ~in_string) {
+        offset_ = size_;
+        aborted_ = true;
+        pos_ = end_;
+        return false;
+      }
+
+      if ((b.backslash | b.high) & in_string) {
+        dirty_[offset_ / 64] = 1;
+      }
+
+      // Everything that is not whitespace, a structural character or a string starts or continues a number or literal.
+      auto other = ~(b.structural | b.space | quote | in_string);
+      auto other_start = other & ~((other << 1) | other_carry_);
+      other_carry_ = other >> 63;
+
+      auto tokens = (b.structural & ~in_string) | quote | other_start;
+      if (size < 64) {
+        tokens &= (std::uint64_t(1) << size) - 1;
+      }
+      auto base = static_cast<std::uint32_t>(offset_);
+      while (tokens) {
+        *out++ = base + trailing_zeros(tokens);
+        tokens &= tokens - 1;
+      }
+    }
+    count = static_cast<std::size_t>(out - positions_.data());
+  }
+
+  pos_ = positions_.data();
+  end_ = pos_ + count;
+  return count > 0;
+}
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
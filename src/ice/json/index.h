@@ -0,0 +1,87 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+namespace detail {
+
+// Documents of this size or larger are parsed with a structural index.
+constexpr std::size_t index_threshold = 64 * 1024;
+
+// Structural index of a json document.
+// Contains offsets of structural characters outside of strings, opening and closing quotes and the first character of
+// every other token (numbers and literals). The index is created in cache sized chunks while it is consumed.
+// Indexing stops at the first chunk that contains a comment. The caller should continue with the scalar reader from the
+// last consumed token in this case (see 'aborted()').
+class structural_index {
+public:
+  // The buffer must be smaller than 4 GiB (see 'supported()') and must outlive the index.
+  structural_index(const char* data, std::size_t size);
+
+  // Returns true if a document of the given size can be indexed.
+  static bool supported(std::size_t size);
+
+  // Moves to the next token and stores its offset. Returns false at the end of the document or if indexing was aborted.
+  bool next(std::uint32_t& offset)
+  {
+    if (pos_ == end_ && !fill()) {
+      return false;
+    }
+    offset = *pos_++;
+    return true;
+  }
+
+  // Stores the offset of the next token without moving to it.
+  // Returns false at the end of the document or if indexing was aborted.
+  bool peek(std::uint32_t& offset)
+  {
+    if (pos_ == end_ && !fill()) {
+      return false;
+    }
+    offset = *pos_;
+    return true;
+  }
+
+  // Returns true if indexing stopped before the end of the document because of a comment.
+  bool aborted() const
+  {
+    return aborted_;
+  }
+
+  // Returns true if the string between the given opening and closing quote offsets contains neither escape sequences
+  // nor non-ASCII characters and can therefore be used without decoding or validation.
+  bool clean(std::uint32_t open, std::uint32_t close) const
+  {
+    for (auto i = open / 64; i <= close / 64; i++) {
+      if (dirty_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  // Indexes the next chunk. Returns false if the whole document was indexed.
+  bool fill();
+
+  const char* data_;
+  std::size_t size_;
+  std::size_t offset_ = 0;
+  bool aborted_ = false;
+
+  std::uint64_t escape_carry_ = 0;
+  std::uint64_t string_carry_ = 0;
+  std::uint64_t other_carry_ = 0;
+
+  std::vector<std::uint32_t> positions_;
+  const std::uint32_t* pos_ = nullptr;
+  const std::uint32_t* end_ = nullptr;
+
+  // One entry per 64 byte block. Set when a string in this block contains a '\\' or a non-ASCII character.
+  std::vector<std::uint8_t> dirty_;
+};
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,268 @@
+#include <ice/json/input.h>
+#include <ice/json/builder.h>
+#include <ice/json/reader.h>
+#include <sstream>
+
+namespace ice {
+namespace json {
+namespace {
+
+// Stores a scalar value. Arrays and objects are read with 'ice::json::detail::builder'.
+struct scalar_reader : detail::skipper {
+  value& v;
+
+  explicit scalar_reader(value& v) noexcept : v(v)
+  {}
+
+  bool on_null()
+  {
+    v.reset();
+    return true;
+  }
+
+  bool on_boolean(boolean b)
+  {
+    v.reset(b);
+    return true;
+  }
+
+  bool on_number(number n)
+  {
+    v.reset(n);
+    return true;
+  }
+
+  bool on_integer(std::int64_t i)
+  {
+    v.reset(i);
+    return true;
+  }
+
+  bool on_string(ice::string_view s)
+  {
+    v.reset(string(s.data(), s.size()));
+    return true;
+  }
+};
+
+// Stores a string value or key. Strings with escape sequences are decoded by the reader into its own buffer and copied
+// into the given buffer, other strings are views into the input.
+struct string_reader : detail::skipper {
+  std::string& buffer;
+  const char* begin;
+  const char* end;
+  ice::string_view value;
+
+  string_reader(std::string& buffer, const char* begin, const char* end) noexcept :
+    buffer(buffer), begin(begin), end(end)
+  {}
+
+  bool on_string(ice::string_view v)
+  {
+    if (v.data() >= begin && v.data() + v.size() <= end) {
+      value = v;
+    } else {
+      buffer.assign(v.data(), v.size());
+      value = buffer;
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+input::input(const char* data, std::size_t size) : input(data, data, size)
+{
+  if (data && size >= 3 && data[0] == '\xEF' && data[1] == '\xBB' && data[2] == '\xBF') {
+    it_ += 3;
+  }
+}
+
+input::input(const std::string& text) : input(text.data(), text.size())
+{}
+
+input::input(const char* origin, const char* data, std::size_t size) :
+  origin_(origin), it_(data), end_(data + size)
+{}
+
+json::type input::type()
+{
+  skip_space();
+  if (it_ == end_) {
+    throw error("incomplete input");
+  }
+  switch (*it_) {
+  case 'n': return json::type::null;
+  case 't':
+  case 'f': return json::type::boolean;
+  case '"': return json::type::string;
+  case '[': return json::type::array;
+  case '{': return json::type::object;
+  case '-':
+  case '.':
+  case '0':
+  case '1':
+  case '2':
+  case '3':
+  case '4':
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9': return json::type::number;
+  }
+  throw error("syntax error");
+}
+
+value input::read_value()
+{
+  auto type = this->type();
+  value v;
+  auto size = static_cast<std::size_t>(end_ - it_);
+  if (type == json::type::array || type == json::type::object) {
+    detail::builder handler(v);
+    detail::reader<detail::builder> reader(origin_, it_, size, handler);
+    if (size >= detail::index_threshold && detail::structural_index::supported(size)) {
+      detail::structural_index index(it_, size);
+      it_ += reader.parse(index);
+    } else {
+      it_ += reader.parse();
+    }
+  } else {
+    scalar_reader handler(v);
+    detail::reader<scalar_reader> reader(origin_, it_, size, handler);
+    it_ += reader.parse();
+  }
+  return v;
+}
+
+ice::string_view input::read_string()
+{
+  auto type = this->type();
+  if (type != json::type::string) {
+    throw type_error::as(type, json::type::string);
+  }
+  string_reader handler(buffer_, it_, end_);
+  detail::reader<string_reader> reader(origin_, it_, static_cast<std::size_t>(end_ - it_), handler);
+  it_ += reader.parse();
+  return handler.value;
+}
+
+void input::skip()
+{
+  type();
+  detail::skipper handler;
+  detail::reader<detail::skipper> reader(origin_, it_, static_cast<std::size_t>(end_ - it_), handler);
+  it_ += reader.parse();
+}
+
+void input::start_array()
+{
+  auto type = this->type();
+  if (type != json::type::array) {
+    throw type_error::as(type, json::type::array);
+  }
+  ++it_;
+  first_ = true;
+}
+
+bool input::next_element()
+{
+  return next(']', "invalid array syntax");
+}
+
+void input::start_object()
+{
+  auto type = this->type();
+  if (type != json::type::object) {
+    throw type_error::as(type, json::type::object);
+  }
+  ++it_;
+  first_ = true;
+}
+
+bool input::next_key(ice::string_view& key)
+{
+  if (!next('}', "invalid object syntax")) {
+    return false;
+  }
+  if (*it_ != '"') {
+    throw error("invalid object syntax");
+  }
+  key = read_string();
+  skip_space();
+  if (it_ == end_) {
+    throw error("incomplete input");
+  }
+  if (*it_ != ':') {
+    throw error("invalid object syntax");
+  }
+  ++it_;
+  return true;
+}
+
+parse_error input::error(const char* message) const
+{
+  std::size_t line = 1;
+  std::size_t column = 0;
+  for (auto pos = origin_; pos && pos != it_ && pos != end_; ++pos) {
+    if (*pos == '\n') {
+      line++;
+      column = 0;
+    }
+    column++;
+  }
+  std::ostringstream oss;
+  oss << message << " (line " << line << " column " << column + 1;
+  if (it_ && it_ != end_) {
+    auto c = *it_;
+    if (c >= ' ' && c <= '~') {
+      oss << " '" << c << "'";
+    } else {
+      oss << " '" << (static_cast<unsigned int>(c) & 0xFF) << "'";
+    }
+  }
+  oss << ")";
+  return oss.str();
+}
+
+// Skips whitespace and '//' comments.
+void input::skip_space()
+{
+  it_ = detail::skip_space(it_, end_);
+  if (it_ != end_ && *it_ == '/') {
+    throw error("syntax error");
+  }
+}
+
+// Moves the read position to the next element of the current array or object and returns true.
+// Returns false after reading the closing character. A trailing ',' before it is accepted, like in the reader.
+bool input::next(char close, const char* message)
+{
+  skip_space();
+  if (it_ == end_) {
+    throw error("incomplete input");
+  }
+  if (!first_) {
+    if (*it_ != ',' && *it_ != close) {
+      throw error(message);
+    }
+    if (*it_ == ',') {
+      ++it_;
+      skip_space();
+      if (it_ == end_) {
+        throw error("incomplete input");
+      }
+    }
+  }
+  if (*it_ == close) {
+    ++it_;
+    first_ = false;
+    return false;
+  }
+  first_ = false;
+  return true;
+}
+
+}  // namespace json
+}  // namespace ice
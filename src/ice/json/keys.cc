@@ -0,0 +1,69 @@
+#include <ice/json/keys.h>
+#include <cstdint>
+#include <cstring>
+
+namespace ice {
+namespace json {
+
+struct keys::entry {
+  std::string name;
+  std::uint32_t hash;
+
+  bool equal(std::uint32_t h, ice::string_view v) const noexcept
+  {
+    return hash == h && name.size() == v.size() && std::memcmp(name.data(), v.data(), v.size()) == 0;
+  }
+};
+
+keys::keys(std::size_t capacity) : capacity_(capacity)
+{
+  // At most half of the slots are used, so that probe sequences stay short and always end at an empty slot.
+  std::size_t slots = 16;
+  while (slots < capacity * 2) {
+    slots *= 2;
+  }
+  mask_ = slots - 1;
+  slots_.reset(new std::atomic<entry*>[slots]);
+  for (std::size_t i = 0; i < slots; i++) {
+    slots_[i].store(nullptr, std::memory_order_relaxed);
+  }
+  entries_.reserve(capacity);
+}
+
+keys::~keys() = default;
+
+json::name keys::intern(ice::string_view name)
+{
+  auto h = detail::name_hash(name.data(), name.size());
+  auto i = static_cast<std::size_t>(h) & mask_;
+  for (auto e = slots_[i].load(std::memory_order_acquire); e; e = slots_[i].load(std::memory_order_acquire)) {
+    if (e->equal(h, name)) {
+      return json::name(&e->name);
+    }
+    i = (i + 1) & mask_;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Another thread may have added names since the lookup. Those can only be at or after the empty slot.
+  for (auto e = slots_[i].load(std::memory_order_relaxed); e; e = slots_[i].load(std::memory_order_relaxed)) {
+    if (e->equal(h, name)) {
+      return json::name(&e->name);
+    }
+    i = (i + 1) & mask_;
+  }
+  if (entries_.size() >= capacity_) {
+    return json::name(name.to_string());
+  }
+  entries_.emplace_back(new entry{ name.to_string(), h });
+  auto e = entries_.back().get();
+  slots_[i].store(e, std::memory_order_release);
+  return json::name(&e->name);
+}
+
+std::size_t keys::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,331 @@
+#include <ice/json/lines.h>
+#include <ice/json/builder.h>
+#include <ice/json/format.h>
+#include <ice/json/reader.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstring>
+
+namespace ice {
+namespace json {
+namespace {
+
+// Minimum number of values per thread in 'format_lines()'.
+constexpr std::size_t min_format_batch = 256;
+
+// Lines of the input that are parsed by a single thread.
+struct chunk {
+  std::string storage;         // chunk data read from a stream
+  const char* data = nullptr;
+  std::size_t size = 0;
+  std::vector<value> values;
+  std::size_t line = 1;        // line number of the first line in the chunk
+  std::size_t lines = 0;       // number of parsed lines in the chunk
+  std::exception_ptr error;    // parse error of the first invalid line
+  bool failed = false;
+  bool done = false;
+  bool delivered = false;
+};
+
+std::size_t thread_count(const line_options& options)
+{
+  if (options.threads) {
+    return options.threads;
+  }
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+bool is_blank(const char* it, const char* end)
+{
+  return std::all_of(it, end, [](char c) { return detail::is_char(c, detail::char_space); });
+}
+
+// Parses all lines of a chunk and stops at the first invalid line.
+void parse(chunk& c, json::keys* keys)
+{
+  auto it = c.data;
+  auto end = c.data + c.size;
+  value root;
+  detail::builder handler(root, {}, keys);
+  while (it != end) {
+    auto next = static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(end - it)));
+    auto line_end = next ? next : end;
+    if (!is_blank(it, line_end)) {
+      try {
+        auto length = static_cast<std::size_t>(line_end - it);
+        auto line = c.line + c.lines;
+        std::size_t size = 0;
+        if (c.storage.empty()) {
+          size = detail::reader<detail::builder>(it, length, handler, line).parse();
+        } else {
+          // Chunks read from a stream own their data, so escaped strings are decoded in place.
+          auto data = &c.storage[static_cast<std::size_t>(it - c.data)];
+          size = detail::reader<detail::builder>(data, length, handler, detail::in_situ, line).parse();
+        }
+        if (!is_blank(it + size, line_end)) {
+          throw parse_error("syntax error (line " + std::to_string(line) + " column " + std::to_string(size + 1) + ")");
+        }
+        c.values.push_back(std::move(root));
+      }
+      catch (const parse_error&) {
+        c.error = std::current_exception();
+        c.failed = true;
+        return;
+      }
+    }
+    c.lines++;
+    it = next ? next + 1 : end;
+  }
+}
+
+// Parses chunks on worker threads and passes the values to the callback on the calling thread.
+// At most 'window_' chunks are in flight, so that memory use does not depend on the input size.
+class pipeline {
+public:
+  pipeline(const line_function& callback, const line_options& options) :
+    callback_(callback), ordered_(options.ordered), keys_(options.keys)
+  {
+    auto threads = thread_count(options);
+    window_ = threads * 2;
+    if (threads > 1) {
+      for (std::size_t i = 0; i < threads; i++) {
+        threads_.emplace_back([this]() { work(); });
+      }
+    }
+  }
+
+  ~pipeline()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    work_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // Adds a chunk and passes finished chunks to the callback until there is room for more chunks.
+  void push(std::unique_ptr<chunk> c)
+  {
+    if (threads_.empty()) {
+      parse(*c, keys_);
+      c->done = true;
+      queue_.push_back(std::move(c));
+    } else {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        todo_.push_back(c.get());
+        queue_.push_back(std::move(c));
+      }
+      work_.notify_one();
+    }
+    drain(window_);
+  }
+
+  // Passes all remaining values to the callback.
+  void finish()
+  {
+    drain(1);
+  }
+
+private:
+  void work()
+  {
+    while (true) {
+      chunk* c = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_.wait(lock, [this]() { return stop_ || !todo_.empty(); });
+        if (stop_) {
+          return;
+        }
+        c = todo_.front();
+        todo_.pop_front();
+      }
+      parse(*c, keys_);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        c->done = true;
+      }
+      done_.notify_one();
+    }
+  }
+
+  // Delivers finished chunks and removes them from the queue in input order. Waits until less than 'limit' chunks are
+  // in flight. Errors are reported once all previous lines were delivered.
+  void drain(std::size_t limit)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!queue_.empty()) {
+      auto& front = *queue_.front();
+      if (front.done && front.failed) {
+        std::rethrow_exception(front.error);
+      }
+      if (front.delivered) {
+        queue_.pop_front();
+        continue;
+      }
+      chunk* next = nullptr;
+      for (const auto& c : queue_) {
+        if (c->done && !c->failed && !c->delivered) {
+          next = c.get();
+          break;
+        }
+        if (ordered_) {
+          break;
+        }
+      }
+      if (!next) {
+        if (queue_.size() < limit) {
+          return;
+        }
+        done_.wait(lock);
+        continue;
+      }
+      lock.unlock();
+      for (auto& v : next->values) {
+        callback_(std::move(v));
+      }
+      next->values = {};
+      lock.lock();
+      next->delivered = true;
+    }
+  }
+
+  const line_function& callback_;
+  bool ordered_;
+  json::keys* keys_;
+  std::size_t window_ = 0;
+  std::deque<std::unique_ptr<chunk>> queue_;  // chunks in input order
+  std::deque<chunk*> todo_;                   // chunks that are not parsed yet
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable work_;
+  std::condition_variable done_;
+  bool stop_ = false;
+};
+
+}  // namespace
+
+void read_lines(const char* data, std::size_t size, const line_function& callback, const line_options& options)
+{
+  pipeline lines(callback, options);
+  auto chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+  auto it = data;
+  auto end = data + size;
+  std::size_t line = 1;
+  while (it != end) {
+    auto c = std::make_unique<chunk>();
+    auto next = it + std::min(chunk_size, static_cast<std::size_t>(end - it)) - 1;
+    next = static_cast<const char*>(std::memchr(next, '\n', static_cast<std::size_t>(end - next)));
+    next = next ? next + 1 : end;
+    c->data = it;
+    c->size = static_cast<std::size_t>(next - it);
+    c->line = line;
+    line += static_cast<std::size_t>(std::count(it, next, '\n'));
+    lines.push(std::move(c));
+    it = next;
+  }
+  lines.finish();
+}
+
+void read_lines(const std::string& text, const line_function& callback, const line_options& options)
+{
+  read_lines(text.data(), text.size(), callback, options);
+}
+
+void read_lines(std::istream& is, const line_function& callback, const line_options& options)
+{
+  pipeline lines(callback, options);
+  auto chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+  std::string rest;
+  std::size_t line = 1;
+  while (is) {
+    auto c = std::make_unique<chunk>();
+    c->storage = std::move(rest);
+    rest = {};
+    std::size_t end = 0;
+    while (is) {
+      auto size = c->storage.size();
+      c->storage.resize(size + chunk_size);
+      is.read(&c->storage[size], static_cast<std::streamsize>(chunk_size));
+      c->storage.resize(size + static_cast<std::size_t>(is.gcount()));
+      end = c->storage.rfind('\n');
+      if (end != std::string::npos && end >= size) {
+        break;
+      }
+    }
+    if (is && end != std::string::npos) {
+      rest.assign(c->storage, end + 1, std::string::npos);
+      c->storage.resize(end + 1);
+    }
+    if (c->storage.empty()) {
+      break;
+    }
+    c->data = c->storage.data();
+    c->size = c->storage.size();
+    c->line = line;
+    line += static_cast<std::size_t>(std::count(c->storage.begin(), c->storage.end(), '\n'));
+    lines.push(std::move(c));
+  }
+  lines.finish();
+}
+
+void format_lines(buffer& out, const std::vector<value>& values, const line_options& options)
+{
+  auto format_range = [&values](buffer& out, std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; i++) {
+      format(out, values[i], false);
+      out.append('\n');
+    }
+  };
+  auto threads = std::min(thread_count(options), values.size() / min_format_batch);
+  if (threads <= 1) {
+    format_range(out, 0, values.size());
+    return;
+  }
+
+  // The first batch is serialized on the calling thread directly into the output buffer.
+  auto batch = (values.size() + threads - 1) / threads;
+  std::vector<buffer> parts(threads - 1);
+  std::vector<std::exception_ptr> errors(threads - 1);
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < threads; i++) {
+    workers.emplace_back([&, i]() {
+      try {
+        format_range(parts[i - 1], i * batch, std::min((i + 1) * batch, values.size()));
+      }
+      catch (...) {
+        errors[i - 1] = std::current_exception();
+      }
+    });
+  }
+  try {
+    format_range(out, 0, batch);
+  }
+  catch (...) {
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    throw;
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (std::size_t i = 0; i < parts.size(); i++) {
+    if (errors[i]) {
+      std::rethrow_exception(errors[i]);
+    }
+    out.append(parts[i].data(), parts[i].size());
+  }
+}
+
+}  // namespace json
+}  // namespace ice
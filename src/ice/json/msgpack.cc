@@ -0,0 +1,309 @@
+#include <ice/json/msgpack.h>
+#include <ice/json/binary.h>
+#include <ice/json/builder.h>
+#include <limits>
+
+namespace ice {
+namespace json {
+namespace msgpack {
+namespace {
+
+// Appends the format byte and the size of a string, array or map. Sizes less than 'fixed_size' are stored in the
+// 'fixed' format byte. Larger sizes use consecutive formats starting at 'format' for 8 bit sizes (if 'size8' is true),
+// 16 bit sizes and 32 bit sizes.
+void encode_size(buffer& out, std::size_t size, std::uint8_t fixed, std::size_t fixed_size, std::uint8_t format,
+  bool size8)
+{
+  if (size < fixed_size) {
+    out.append(static_cast<char>(fixed | size));
+    return;
+  }
+  if (size8) {
+    if (size <= 0xFF) {
+      out.append(static_cast<char>(format));
+      detail::append_be(out, size, 1);
+      return;
+    }
+    format++;
+  }
+  if (size <= 0xFFFF) {
+    out.append(static_cast<char>(format));
+    detail::append_be(out, size, 2);
+  } else if (size <= 0xFFFFFFFF) {
+    out.append(static_cast<char>(format + 1));
+    detail::append_be(out, size, 4);
+  } else {
+    throw range_error("size " + std::to_string(size) + " exceeds the MessagePack limit");
+  }
+}
+
+void encode_integer(buffer& out, std::int64_t i)
+{
+  if (i >= 0) {
+    auto n = static_cast<std::uint64_t>(i);
+    if (n < 0x80) {
+      out.append(static_cast<char>(n));
+    } else if (n <= 0xFF) {
+      out.append('\xCC');
+      detail::append_be(out, n, 1);
+    } else if (n <= 0xFFFF) {
+      out.append('\xCD');
+      detail::append_be(out, n, 2);
+    } else if (n <= 0xFFFFFFFF) {
+      out.append('\xCE');
+      detail::append_be(out, n, 4);
+    } else {
+      out.append('\xCF');
+      detail::append_be(out, n, 8);
+    }
+    return;
+  }
+  auto n = static_cast<std::uint64_t>(i);
+  if (i >= -32) {
+    out.append(static_cast<char>(n));
+  } else if (i >= std::numeric_limits<std::int8_t>::min()) {
+    out.append('\xD0');
+    detail::append_be(out, n, 1);
+  } else if (i >= std::numeric_limits<std::int16_t>::min()) {
+    out.append('\xD1');
+    detail::append_be(out, n, 2);
+  } else if (i >= std::numeric_limits<std::int32_t>::min()) {
+    out.append('\xD2');
+    detail::append_be(out, n, 4);
+  } else {
+    out.append('\xD3');
+    detail::append_be(out, n, 8);
+  }
+}
+
+void encode_number(buffer& out, const value& v)
+{
+  std::int64_t i = 0;
+  if (detail::to_integer(v, i)) {
+    encode_integer(out, i);
+    return;
+  }
+  auto n = v.as_number();
+  if (detail::is_float(n)) {
+    out.append('\xCA');
+    detail::append_be(out, detail::float_bits(static_cast<float>(n)), 4);
+  } else {
+    out.append('\xCB');
+    detail::append_be(out, detail::double_bits(n), 8);
+  }
+}
+
+void encode_string(buffer& out, ice::string_view v)
+{
+  encode_size(out, v.size(), 0xA0, 32, 0xD9, true);
+  out.append(v.data(), v.size());
+}
+
+void encode_value(buffer& out, const value& v)
+{
+  switch (v.type()) {
+  case type::null: out.append('\xC0'); return;
+  case type::boolean: out.append(v.as_boolean() ? '\xC3' : '\xC2'); return;
+  case type::number: encode_number(out, v); return;
+  case type::string: encode_string(out, v.as<ice::string_view>()); return;
+  case type::array:
+    encode_size(out, v.size(), 0x90, 16, 0xDC, false);
+    if (v.is<numbers>()) {
+      for (auto n : v.data<numbers>()) {
+        encode_number(out, value(n));
+      }
+      return;
+    }
+    for (const auto& e : v) {
+      encode_value(out, e.value);
+    }
+    return;
+  case type::object:
+    encode_size(out, v.size(), 0x80, 16, 0xDE, false);
+    for (const auto& e : v) {
+      encode_string(out, e.name.value());
+      encode_value(out, e.value);
+    }
+    return;
+  }
+}
+
+// Decodes MessagePack objects and reports them to the builder.
+template <typename Source>
+class decoder {
+public:
+  decoder(Source& source, detail::builder& handler) noexcept : source_(source), handler_(handler)
+  {}
+
+  void decode(std::size_t depth = 0)
+  {
+    if (depth == detail::max_binary_depth) {
+      throw source_.error("maximum nesting depth exceeded");
+    }
+    auto c = source_.next();
+    if (c < 0x80) {
+      handler_.on_integer(c);
+      return;
+    }
+    if (c >= 0xE0) {
+      handler_.on_integer(static_cast<std::int8_t>(c));
+      return;
+    }
+    if (c < 0x90) {
+      decode_map(c & 0x0F, depth);
+      return;
+    }
+    if (c < 0xA0) {
+      decode_array(c & 0x0F, depth);
+      return;
+    }
+    if (c < 0xC0) {
+      handler_.on_string(read_string(c & 0x1F));
+      return;
+    }
+    switch (c) {
+    case 0xC0: handler_.on_null(); return;
+    case 0xC2: handler_.on_boolean(false); return;
+    case 0xC3: handler_.on_boolean(true); return;
+    case 0xC4:
+    case 0xD9: handler_.on_string(read_string(source_.read(1))); return;
+    case 0xC5:
+    case 0xDA: handler_.on_string(read_string(source_.read(2))); return;
+    case 0xC6:
+    case 0xDB: handler_.on_string(read_string(source_.read(4))); return;
+    case 0xCA:
+    {
+      auto bits = static_cast<std::uint32_t>(source_.read(4));
+      float v = 0;
+      std::memcpy(&v, &bits, sizeof(v));
+      handler_.on_number(v);
+    }
+      return;
+    case 0xCB:
+    {
+      auto bits = source_.read(8);
+      double v = 0;
+      std::memcpy(&v, &bits, sizeof(v));
+      handler_.on_number(v);
+    }
+      return;
+    case 0xCC: handler_.on_integer(static_cast<std::int64_t>(source_.read(1))); return;
+    case 0xCD: handler_.on_integer(static_cast<std::int64_t>(source_.read(2))); return;
+    case 0xCE: handler_.on_integer(static_cast<std::int64_t>(source_.read(4))); return;
+    case 0xCF:
+    {
+      auto n = source_.read(8);
+      if (n <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+        handler_.on_integer(static_cast<std::int64_t>(n));
+      } else {
+        handler_.on_number(static_cast<double>(n));
+      }
+    }
+      return;
+    case 0xD0: handler_.on_integer(static_cast<std::int8_t>(source_.read(1))); return;
+    case 0xD1: handler_.on_integer(static_cast<std::int16_t>(source_.read(2))); return;
+    case 0xD2: handler_.on_integer(static_cast<std::int32_t>(source_.read(4))); return;
+    case 0xD3: handler_.on_integer(static_cast<std::int64_t>(source_.read(8))); return;
+    case 0xDC: decode_array(source_.read(2), depth); return;
+    case 0xDD: decode_array(source_.read(4), depth); return;
+    case 0xDE: decode_map(source_.read(2), depth); return;
+    case 0xDF: decode_map(source_.read(4), depth); return;
+    case 0xC1: throw source_.error("invalid format");
+    default: throw source_.error("unsupported extension type");
+    }
+  }
+
+private:
+  void decode_array(std::uint64_t size, std::size_t depth)
+  {
+    handler_.on_start_array();
+    for (; size > 0; size--) {
+      decode(depth + 1);
+    }
+    handler_.on_end_array();
+  }
+
+  void decode_map(std::uint64_t size, std::size_t depth)
+  {
+    handler_.on_start_object();
+    for (; size > 0; size--) {
+      auto c = source_.next();
+      if ((c & 0xE0) == 0xA0) {
+        handler_.on_key(read_string(c & 0x1F));
+      } else if (c == 0xD9) {
+        handler_.on_key(read_string(source_.read(1)));
+      } else if (c == 0xDA) {
+        handler_.on_key(read_string(source_.read(2)));
+      } else if (c == 0xDB) {
+        handler_.on_key(read_string(source_.read(4)));
+      } else {
+        throw source_.error("unsupported map key");
+      }
+      decode(depth + 1);
+    }
+    handler_.on_end_object();
+  }
+
+  ice::string_view read_string(std::uint64_t size)
+  {
+    return detail::check_utf8(source_, source_.read_string(size));
+  }
+
+  Source& source_;
+  detail::builder& handler_;
+};
+
+template <typename Source>
+value decode(Source& source)
+{
+  value root;
+  detail::builder handler(root);
+  decoder<Source>(source, handler).decode();
+  return root;
+}
+
+}  // namespace
+
+std::string encode(const value& root)
+{
+  buffer out;
+  encode_value(out, root);
+  return out.release();
+}
+
+std::ostream& encode(std::ostream& os, const value& root)
+{
+  char data[4096];
+  buffer out(data, sizeof(data), [&os](const char* s, std::size_t size) {
+    os.write(s, static_cast<std::streamsize>(size));
+  });
+  encode_value(out, root);
+  out.flush();
+  return os;
+}
+
+void encode(buffer& out, const value& root)
+{
+  encode_value(out, root);
+}
+
+value decode(std::istream& is)
+{
+  detail::stream_source source(is);
+  return decode(source);
+}
+
+value decode(const std::string& data)
+{
+  return decode(data.data(), data.size());
+}
+
+value decode(const char* data, std::size_t size)
+{
+  detail::buffer_source source(data, size);
+  return decode(source);
+}
+
+}  // namespace msgpack
+}  // namespace json
+}  // namespace ice
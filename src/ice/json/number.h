@@ -0,0 +1,149 @@
+#pragma once
+#include <ice/json/types.h>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+namespace json {
+namespace detail {
+
+// Json number converted by 'to_number()'.
+// Integers that can not be represented by a double exactly, but fit into 64 bits are also stored as an integer.
+struct number_token {
+  number real = 0.0;
+  std::int64_t integer = 0;
+  bool is_integer = false;
+};
+
+// Converts a decimal mantissa and a power of ten to the nearest double using the Eisel-Lemire algorithm.
+// Returns false if the mantissa was truncated and the result can not be determined without the remaining digits.
+bool to_double(std::uint64_t mantissa, std::int64_t exponent, bool negative, bool truncated, number& v) noexcept;
+
+// Converts number characters without the 'to_number()' grammar checks. Used if 'to_double()' fails.
+bool to_double(const char* data, std::size_t size, number& v);
+
+// Maximum number of characters written by 'to_chars()'.
+constexpr std::size_t max_number_size = 32;
+
+// Writes the integer and returns the end of the written characters.
+char* to_chars(char* out, std::int64_t v) noexcept;
+
+// Writes the shortest number that parses back to the same double and returns the end of the written characters.
+// Integral numbers up to 2^53 are written as integers. Infinity and NaN are written as 'null'.
+char* to_chars(char* out, number v) noexcept;
+
+inline bool is_digit(char c)
+{
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Converts the given number characters to a json number.
+// Accepts an optional '-', digits with an optional fraction (one of them may be empty) and an optional exponent.
+// Returns false if the characters are not a number. Numbers beyond the double range become the largest double.
+inline bool to_number(const char* data, std::size_t size, number_token& v)
+{
+  constexpr int max_digits = 19;  // every 19 digit mantissa fits into 64 bits
+  auto it = data;
+  auto end = data + size;
+  auto negative = it != end && *it == '-';
+  if (negative) {
+    ++it;
+  }
+  std::uint64_t mantissa = 0;
+  std::int64_t exponent = 0;
+  auto digits = 0;  // significant digits in the mantissa
+  auto truncated = false;
+  auto integer = true;
+  auto begin = it;
+  for (; it != end && is_digit(*it); ++it) {
+    if (digits < max_digits) {
+      mantissa = mantissa * 10 + static_cast<std::uint64_t>(*it - '0');
+      digits += mantissa != 0 ? 1 : 0;
+    } else {
+      exponent++;
+      truncated |= *it != '0';
+    }
+  }
+  auto count = it - begin;
+  if (it != end && *it == '.') {
+    integer = false;
+    begin = ++it;
+    for (; it != end && is_digit(*it); ++it) {
+      if (digits < max_digits) {
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*it - '0');
+        digits += mantissa != 0 ? 1 : 0;
+        exponent--;
+      } else {
+        truncated |= *it != '0';
+      }
+    }
+    count += it - begin;
+  }
+  if (count == 0) {
+    return false;
+  }
+  if (it != end && (*it == 'e' || *it == 'E')) {
+    integer = false;
+    ++it;
+    auto exponent_negative = it != end && *it == '-';
+    if (it != end && (*it == '-' || *it == '+')) {
+      ++it;
+    }
+    if (it == end || !is_digit(*it)) {
+      return false;
+    }
+    std::int64_t e = 0;
+    for (; it != end && is_digit(*it); ++it) {
+      if (e < 100000) {
+        e = e * 10 + (*it - '0');
+      }
+    }
+    exponent += exponent_negative ? -e : e;
+  }
+  if (it != end) {
+    return false;
+  }
+
+  // Integers are exact up to 2^53 as a double and up to 2^63 as an integer.
+  constexpr auto max_exact = std::uint64_t(1) << 53;
+  constexpr auto max_integer = std::uint64_t(1) << 63;
+  if (integer && exponent == 0) {
+    if (mantissa <= max_exact) {
+      v.real = negative ? -static_cast<number>(mantissa) : static_cast<number>(mantissa);
+      v.is_integer = false;
+      return true;
+    }
+    if (mantissa < max_integer || (negative && mantissa == max_integer)) {
+      v.integer = negative ? static_cast<std::int64_t>(0 - mantissa) : static_cast<std::int64_t>(mantissa);
+      v.real = static_cast<number>(v.integer);
+      v.is_integer = true;
+      return true;
+    }
+  }
+  v.is_integer = false;
+
+  // Both the mantissa and the power of ten are exact as a double and the result is correctly rounded.
+  static constexpr number powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+  if (!truncated && mantissa <= max_exact && exponent >= -22 && exponent <= 22) {
+    auto real = static_cast<number>(mantissa);
+    real = exponent < 0 ? real / powers[-exponent] : real * powers[exponent];
+    v.real = negative ? -real : real;
+    return true;
+  }
+  if (!to_double(mantissa, exponent, negative, truncated, v.real) && !to_double(data, size, v.real)) {
+    return false;
+  }
+  // Numbers beyond the double range are clamped to the largest double, like the stream conversion did before.
+  if (v.real - v.real != 0.0) {
+    v.real = negative ? -std::numeric_limits<number>::max() : std::numeric_limits<number>::max();
+  }
+  return true;
+}
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
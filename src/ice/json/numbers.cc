@@ -0,0 +1,65 @@
+#include <ice/json/value.h>
+#include <ice/json/traits.h>
+#include <memory>
+
+namespace ice {
+namespace json {
+
+numbers::numbers(numbers&& other) noexcept : vector(std::move(other)), elements_(other.elements_.load())
+{
+  other.elements_ = nullptr;
+}
+
+numbers::numbers(const numbers& other) : vector(other)
+{}
+
+numbers::numbers(const allocator_type& allocator) : vector(allocator)
+{}
+
+numbers::numbers(std::initializer_list<number> list) : vector(list)
+{}
+
+numbers::~numbers()
+{
+  release();
+}
+
+numbers& numbers::operator=(numbers&& other)
+{
+  release();
+  vector::operator=(std::move(other));
+  other.release();
+  return *this;
+}
+
+numbers& numbers::operator=(const numbers& other)
+{
+  release();
+  vector::operator=(other);
+  return *this;
+}
+
+const array& numbers::elements() const
+{
+  auto elements = elements_.load(std::memory_order_acquire);
+  if (!elements) {
+    std::unique_ptr<array> created(new array());
+    created->reserve(size());
+    for (auto n : *this) {
+      created->emplace_back(value(n));
+    }
+    // Another thread may have created the elements in the meantime.
+    if (elements_.compare_exchange_strong(elements, created.get(), std::memory_order_acq_rel)) {
+      elements = created.release();
+    }
+  }
+  return *elements;
+}
+
+void numbers::release() noexcept
+{
+  delete elements_.exchange(nullptr);
+}
+
+}  // namespace json
+}  // namespace ice
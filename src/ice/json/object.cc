@@ -0,0 +1,204 @@
+#include <ice/json/value.h>
+#include <algorithm>
+#include <new>
+#include <cstring>
+
+namespace ice {
+namespace json {
+namespace {
+
+inline bool equal(const element<value>& e, const char* name, std::size_t size) noexcept
+{
+  return e.name && e.name->size() == size && (e.name->data() == name || std::memcmp(e.name->data(), name, size) == 0);
+}
+
+}  // namespace
+
+// Open addressing hash table with linear probing that maps element names to element positions.
+struct object::index {
+  struct slot {
+    std::uint32_t position;  // element position + 1 or 0 if the slot is empty
+    std::uint32_t hash;
+  };
+
+  std::size_t capacity;         // number of slots (power of two)
+  std::size_t size;             // number of elements when the index was last updated
+  const element<value>* data;   // element storage when the index was last updated
+  slot slots[1];
+
+  // Returns the allocation size in 64-bit words for the given number of slots.
+  static std::size_t words(std::size_t capacity) noexcept
+  {
+    return (sizeof(index) + (capacity - 1) * sizeof(slot) + 7) / 8;
+  }
+
+  bool valid(const collection& elements) const noexcept
+  {
+    return size == elements.size() && data == elements.data();
+  }
+
+  // Returns the position of the element with the given name, 'elements.size()' if the name is not found or 'stale' if
+  // a slot does not match its element, because the elements were reordered or renamed through retained iterators.
+  std::size_t find(const collection& elements, const char* name, std::size_t size) const noexcept
+  {
+    auto h = detail::name_hash(name, size);
+    auto mask = capacity - 1;
+    for (auto i = h & mask; slots[i].position; i = (i + 1) & mask) {
+      const auto& slot = slots[i];
+      if (slot.hash != h) {
+        continue;
+      }
+      const auto& e = elements[slot.position - 1];
+      if (equal(e, name, size)) {
+        return slot.position - 1;
+      }
+      // Different names with the same hash are expected, but the slot must still match its element.
+      if (!e.name || detail::name_hash(e.name->data(), e.name->size()) != h) {
+        return stale;
+      }
+    }
+    return elements.size();
+  }
+
+  static constexpr std::size_t stale = static_cast<std::size_t>(-1);
+
+  void insert(std::uint32_t hash, std::size_t position) noexcept
+  {
+    auto mask = capacity - 1;
+    auto i = hash & mask;
+    while (slots[i].position) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = { static_cast<std::uint32_t>(position + 1), hash };
+  }
+};
+
+object::object(object&& other) noexcept : collection(std::move(other)), index_(other.index_)
+{
+  other.index_ = nullptr;
+}
+
+object::object(const object& other) : collection(other)
+{
+  if (other.index_ && other.index_->valid(other)) {
+    reindex(other.index_->capacity);
+  }
+}
+
+object::~object()
+{
+  release();
+}
+
+object& object::operator=(object&& other)
+{
+  release();
+  collection::operator=(std::move(other));
+  if (get_allocator() == other.get_allocator()) {
+    index_ = other.index_;
+    other.index_ = nullptr;
+  } else {
+    other.release();
+  }
+  return *this;
+}
+
+object& object::operator=(const object& other)
+{
+  release();
+  collection::operator=(other);
+  if (other.index_ && other.index_->valid(other)) {
+    reindex(other.index_->capacity);
+  }
+  return *this;
+}
+
+iterator object::find(ice::string_view name)
+{
+  return collection::begin() + static_cast<std::ptrdiff_t>(lookup(name.data(), name.size()));
+}
+
+const_iterator object::find(ice::string_view name) const
+{
+  return begin() + static_cast<std::ptrdiff_t>(lookup(name.data(), name.size()));
+}
+
+value& object::append(json::name name, value v)
+{
+  auto indexed = index_ && index_->valid(*this);
+  const auto& key = *static_cast<const json::name&>(name);
+  auto h = detail::name_hash(key.data(), key.size());
+  collection::emplace_back(std::move(name), std::move(v));
+  if (indexed) {
+    if (size() * 2 > index_->capacity) {
+      reindex(index_->capacity * 2);
+    } else {
+      index_->insert(h, size() - 1);
+      index_->size = size();
+      index_->data = collection::data();
+    }
+  }
+  return collection::back().value;
+}
+
+std::size_t object::lookup(const char* name, std::size_t size)
+{
+  if (collection::size() < index_threshold) {
+    return static_cast<const object&>(*this).lookup(name, size);
+  }
+  if (!(index_ && index_->valid(*this))) {
+    std::size_t capacity = 32;
+    while (capacity < collection::size() * 2) {
+      capacity *= 2;
+    }
+    reindex(capacity);
+  }
+  auto position = index_->find(*this, name, size);
+  if (position == index::stale) {
+    reindex(index_->capacity);
+    position = index_->find(*this, name, size);
+  }
+  return position;
+}
+
+std::size_t object::lookup(const char* name, std::size_t size) const
+{
+  if (index_ && index_->valid(*this)) {
+    auto position = index_->find(*this, name, size);
+    if (position != index::stale) {
+      return position;
+    }
+  }
+  auto it = std::find_if(begin(), end(), [name, size](const auto& e) { return equal(e, name, size); });
+  return static_cast<std::size_t>(it - begin());
+}
+
+void object::reindex(std::size_t capacity)
+{
+  release();
+  json::allocator<std::uint64_t> allocator(get_allocator());
+  auto memory = allocator.allocate(index::words(capacity));
+  index_ = new (memory) index();
+  index_->capacity = capacity;
+  index_->size = size();
+  index_->data = collection::data();
+  std::memset(index_->slots, 0, capacity * sizeof(index::slot));
+  for (std::size_t i = 0, size = this->size(); i < size; i++) {
+    const auto& name = collection::operator[](i).name;
+    if (name) {
+      index_->insert(detail::name_hash(name->data(), name->size()), i);
+    }
+  }
+}
+
+void object::release() noexcept
+{
+  if (index_) {
+    json::allocator<std::uint64_t> allocator(get_allocator());
+    allocator.deallocate(reinterpret_cast<std::uint64_t*>(index_), index::words(index_->capacity));
+    index_ = nullptr;
+  }
+}
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,18 @@
+#pragma once
+#include <ice/json/buffer.h>
+#include <cstddef>
+
+namespace ice {
+namespace json {
+namespace detail {
+
+// Escapes the string characters without the quotes and validates UTF-8 sequences.
+// Throws 'std::runtime_error' on invalid UTF-8 sequences.
+void escape(buffer& out, const char* data, std::size_t size);
+
+// Appends a new line and the indentation for the given offset.
+void indent(buffer& out, std::size_t offset);
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
@@ -1,9 +1,178 @@
 #include <ice/json/parse.h>
+#include <ice/json/builder.h>
 #include <ice/json/parser.h>
-#include <sstream>
+#include <ice/json/reader.h>
+#include <ice/json/traits.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <cstring>
 
 namespace ice {
 namespace json {
+namespace {
+
+// Number of element ranges per thread, so that threads that finish early can take over remaining ranges.
+constexpr std::size_t ranges_per_thread = 8;
+
+using range = std::pair<const char*, const char*>;
+
+// Splits the elements of a root array into about 'count' ranges that start after '[' or ',' and end at ',' or ']'.
+// Only checks strings, comments and nesting depth. Returns false if the text does not start with an array or the array
+// is not terminated.
+bool split_array(const char* text, std::size_t size, std::size_t count, std::vector<range>& ranges)
+{
+  auto it = text;
+  auto end = text + size;
+  if (size >= 3 && it[0] == '\xEF' && it[1] == '\xBB' && it[2] == '\xBF') {
+    it += 3;
+  }
+  it = detail::skip_space(it, end);
+  if (it == end || *it != '[') {
+    return false;
+  }
+  auto begin = ++it;
+  auto step = static_cast<std::size_t>(end - begin) / count + 1;
+  auto split = begin + std::min(step, static_cast<std::size_t>(end - begin));
+  std::size_t depth = 1;
+  while (it != end) {
+    auto c = *it;
+    if (c == ',' && depth == 1 && it >= split) {
+      ranges.emplace_back(begin, it);
+      begin = it + 1;
+      split = begin + std::min(step, static_cast<std::size_t>(end - begin));
+      ++it;
+      continue;
+    }
+    if (!detail::is_char(c, detail::char_nested)) {
+      ++it;
+      continue;
+    }
+    switch (c) {
+    case '"':
+      it = detail::skip_string(it, end);
+      if (!it) {
+        return false;
+      }
+      continue;
+    case '/':
+      if (end - it < 2 || it[1] != '/') {
+        return false;
+      }
+      it = static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(end - it)));
+      if (!it) {
+        return false;
+      }
+      break;
+    case '[':
+    case '{': depth++; break;
+    case ']':
+    case '}':
+      if (--depth == 0) {
+        ranges.emplace_back(begin, it);
+        return c == ']';
+      }
+      break;
+    }
+    ++it;
+  }
+  return false;
+}
+
+// Parses the elements in the given range. Only the last range may be empty or end with a trailing ','.
+// Throws 'ice::json::parse_error' on invalid input. Error positions are not exact and the caller parses the text
+// again on a single thread to report the error.
+void parse_range(const char* text, const range& r, bool last, json::keys* keys, std::vector<value>& values)
+{
+  value root;
+  detail::builder handler(root, {}, keys);
+  auto it = detail::skip_space(r.first, r.second);
+  if (it == r.second && !last) {
+    throw parse_error("invalid array syntax");
+  }
+  while (it != r.second) {
+    detail::reader<detail::builder> reader(text, it, static_cast<std::size_t>(r.second - it), handler);
+    reader.parse();
+    values.push_back(std::move(root));
+    it = detail::skip_space(reader.position(), r.second);
+    if (it == r.second) {
+      break;
+    }
+    if (*it != ',') {
+      throw parse_error("invalid array syntax");
+    }
+    it = detail::skip_space(it + 1, r.second);
+    if (it == r.second && !last) {
+      throw parse_error("invalid array syntax");
+    }
+  }
+}
+
+// Parses the elements of a root array on multiple threads. Returns false if the text must be parsed on a single
+// thread, because it does not contain a root array or is invalid.
+bool parse_array(const char* text, std::size_t size, std::size_t threads, json::keys* keys, value& root)
+{
+  std::vector<range> ranges;
+  if (!split_array(text, size, threads * ranges_per_thread, ranges) || ranges.size() < 2) {
+    return false;
+  }
+  std::vector<std::vector<value>> parts(ranges.size());
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> failed(false);
+  auto work = [&]() {
+    for (auto i = next++; i < ranges.size() && !failed; i = next++) {
+      try {
+        parse_range(text, ranges[i], i + 1 == ranges.size(), keys, parts[i]);
+      }
+      catch (...) {
+        failed = true;
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < std::min(threads, ranges.size()); i++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (failed) {
+    return false;
+  }
+  std::size_t count = 0;
+  auto packable = true;
+  for (const auto& part : parts) {
+    count += part.size();
+    for (const auto& v : part) {
+      packable = packable && v.type() == type::number && !v.has_integer();
+    }
+  }
+  if (packable && count >= numbers::threshold) {
+    numbers elements;
+    elements.reserve(count);
+    for (const auto& part : parts) {
+      for (const auto& v : part) {
+        elements.push_back(v.as_number());
+      }
+    }
+    root.reset(std::move(elements));
+    return true;
+  }
+  array elements;
+  elements.reserve(count);
+  for (auto& part : parts) {
+    for (auto& v : part) {
+      elements.emplace_back(std::move(v));
+    }
+  }
+  root.reset(std::move(elements));
+  return true;
+}
+
+}  // namespace
 
 value parse(std::istream& is)
 {
@@ -16,29 +185,54 @@ value parse(std::istream& is)
   }
   return parser.get();
 }
+
 value parse(const std::string& text)
 {
-  json::parser parser;
-  for (auto c : text) {
-    if (parser.put(c)) {
-      return parser.get();
-    }
-  }
-  return parser.get();
+  return parse(text.data(), text.size());
 }
 
 value parse(const char* text, std::size_t size)
 {
   if (!text)
     return value();
-  json::parser parser;
-  for (std::size_t i = 0; i < size; i++) {
-    if (parser.put(text[i])) {
-      return parser.get();
-    }
+  value root;
+  detail::builder handler(root);
+  detail::read(text, size, handler);
+  return root;
+}
+
+value parse(const std::string& text, const parse_options& options)
+{
+  return parse(text.data(), text.size(), options);
+}
+
+value parse(const char* text, std::size_t size, const parse_options& options)
+{
+  auto threads = options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+  value root;
+  if (text && threads > 1 && size >= options.parallel_size && parse_array(text, size, threads, options.keys, root)) {
+    return root;
   }
-  return parser.get();
+  if (!text) {
+    return root;
+  }
+  detail::builder handler(root, {}, options.keys);
+  detail::read(text, size, handler);
+  return root;
+}
+
+bool parse(const std::string& text, handler& handler)
+{
+  return parse(text.data(), text.size(), handler);
+}
+
+bool parse(const char* text, std::size_t size, handler& handler)
+{
+  if (!text) {
+    return handler.on_null();
+  }
+  return detail::read(text, size, handler);
 }
 
 }  // namespace json
-}  // namespace ice
\ No newline at end of file
+}  // namespace ice
@@ -1,7 +1,9 @@
 #include <ice/json/parser.h>
 #include <ice/json/exception.h>
+#include <ice/json/reader.h>
 #include <ice/json/traits.h>
 #include <ice/utf8.h>
+#include <algorithm>
 #include <iomanip>
 #include <iterator>
 #include <sstream>
@@ -155,8 +157,42 @@ inline bool utf16_code(const char* buffer, wchar_t& w)
   return true;
 }
 
+// Returns true if the character can be appended to a string without going through the state machine.
+inline bool is_string_run(char c)
+{
+  return c != '\n' && detail::is_char(c, detail::char_string);
+}
+
+// Returns true if the character can be appended to a number without going through the state machine.
+inline bool is_number_run(char c)
+{
+  return detail::is_char(c, detail::char_number);
+}
+
 }  // namespace
 
+bool parser::put(const char* data, std::size_t size, std::size_t& consumed)
+{
+  consumed = 0;
+  if (state_ == state::end) {
+    return true;
+  }
+  auto it = data;
+  auto end = data + size;
+  while (it != end) {
+    if (auto n = put_run(it, end)) {
+      it += n;
+      continue;
+    }
+    if (put(*it++)) {
+      consumed = static_cast<std::size_t>(it - data);
+      return true;
+    }
+  }
+  consumed = size;
+  return false;
+}
+
 bool parser::put(char c)
 {
   if (c == '\n') {
@@ -665,11 +701,17 @@ bool parser::complete() const
 value& parser::get()
 {
   if (value_.type() == type::number) {
-    std::istringstream iss(buffer_);
-    auto value = 0.0;
-    //iss >> std::setprecision(std::numeric_limits<double>::max_digits10) >> value;
-    iss >> value;
-    value_ = value;
+    // Characters after the number are ignored.
+    auto size = std::find_if_not(buffer_.begin(), buffer_.end(), is_number_run) - buffer_.begin();
+    detail::number_token v;
+    if (!detail::to_number(buffer_.data(), static_cast<std::size_t>(size), v)) {
+      throw error("invalid number", this);
+    }
+    if (v.is_integer) {
+      value_.reset(v.integer);
+    } else {
+      value_ = v.real;
+    }
     state_ = state::start;
     buffer_.clear();
     return value_;
@@ -702,6 +744,36 @@ parser::state parser::current_state() const
   return state_;
 }
 
+// Appends a run of string or number characters to the innermost parser and returns the run size.
+// Such characters are passed through unchanged by all outer parsers, which only need to update the column.
+std::size_t parser::put_run(const char* begin, const char* end)
+{
+  auto p = this;
+  while (p->state_ == state::array || p->state_ == state::object_start || p->state_ == state::object_semicolon) {
+    p = p->inner_value_.get();
+  }
+  auto it = begin;
+  if (p->state_ == state::string) {
+    while (it != end && is_string_run(*it)) {
+      ++it;
+    }
+    p->value_.data<json::string>().append(begin, it);
+  } else if (p->state_ == state::number) {
+    while (it != end && is_number_run(*it)) {
+      ++it;
+    }
+    p->buffer_.append(begin, it);
+  } else {
+    return 0;
+  }
+  auto size = static_cast<std::size_t>(it - begin);
+  for (auto q = this; q != p; q = q->inner_value_.get()) {
+    q->column_ += size;
+  }
+  p->column_ += size;
+  return size;
+}
+
 void parser::append_inner_value()
 {
   value_.append(std::move(inner_value_->get()));
@@ -0,0 +1,348 @@
+#include <ice/json/path.h>
+#include <algorithm>
+#include <limits>
+
+namespace ice {
+namespace json {
+namespace {
+
+// Maximum number of digits in array indices, so that they fit into 64 bits.
+constexpr std::size_t max_index_digits = 18;
+
+parse_error error(const std::string& expression, std::size_t pos)
+{
+  return "invalid json path '" + expression + "' (column " + std::to_string(pos + 1) + ")";
+}
+
+// Returns the array index of a json pointer token or -1 if the token is not an array index.
+std::int64_t to_index(const std::string& token)
+{
+  if (token.empty() || token.size() > max_index_digits || (token[0] == '0' && token.size() > 1)) {
+    return -1;
+  }
+  std::int64_t index = 0;
+  for (auto c : token) {
+    if (c < '0' || c > '9') {
+      return -1;
+    }
+    index = index * 10 + (c - '0');
+  }
+  return index;
+}
+
+}  // namespace
+
+path::path(ice::string_view expression) : expression_(expression.to_string())
+{
+  if (expression_.empty() || expression_[0] == '/') {
+    compile_pointer();
+  } else if (expression_[0] == '$') {
+    compile_path();
+  } else {
+    throw error(expression_, 0);
+  }
+}
+
+value* path::find(value& root) const
+{
+  value* result = nullptr;
+  auto visitor = [&](value& v) {
+    result = &v;
+    return false;
+  };
+  select(steps_.data(), steps_.data() + steps_.size(), root, visitor);
+  return result;
+}
+
+const value* path::find(const value& root) const
+{
+  const value* result = nullptr;
+  auto visitor = [&](const value& v) {
+    result = &v;
+    return false;
+  };
+  select(steps_.data(), steps_.data() + steps_.size(), root, visitor);
+  return result;
+}
+
+view path::find(const view& root) const
+{
+  view result;
+  auto visitor = [&](const view& v) {
+    result = v;
+    return false;
+  };
+  select(steps_.data(), steps_.data() + steps_.size(), root, visitor);
+  return result;
+}
+
+std::vector<value*> path::select(value& root) const
+{
+  std::vector<value*> result;
+  auto visitor = [&](value& v) {
+    result.push_back(&v);
+    return true;
+  };
+  select(steps_.data(), steps_.data() + steps_.size(), root, visitor);
+  return result;
+}
+
+std::vector<const value*> path::select(const value& root) const
+{
+  std::vector<const value*> result;
+  auto visitor = [&](const value& v) {
+    result.push_back(&v);
+    return true;
+  };
+  select(steps_.data(), steps_.data() + steps_.size(), root, visitor);
+  return result;
+}
+
+std::vector<view> path::select(const view& root) const
+{
+  std::vector<view> result;
+  auto visitor = [&](const view& v) {
+    result.push_back(v);
+    return true;
+  };
+  select(steps_.data(), steps_.data() + steps_.size(), root, visitor);
+  return result;
+}
+
+// Stores the selected array element range. Returns false if no element is selected.
+bool path::step::range(std::size_t size, std::size_t& first, std::size_t& last) const
+{
+  auto count = static_cast<std::int64_t>(std::min<std::size_t>(size, std::numeric_limits<std::int64_t>::max()));
+  auto b = begin;
+  auto e = begin + 1;
+  switch (kind) {
+  case name:
+    if (b < 0) {
+      return false;
+    }
+    break;
+  case index:
+    if (b < 0) {
+      b += count;
+      e += count;
+    }
+    break;
+  case all:
+    b = 0;
+    e = count;
+    break;
+  case slice:
+    b = has_begin ? begin : 0;
+    e = has_end ? end : count;
+    if (b < 0) {
+      b = std::max<std::int64_t>(b + count, 0);
+    }
+    if (e < 0) {
+      e = std::max<std::int64_t>(e + count, 0);
+    }
+    break;
+  }
+  b = std::min(b, count);
+  e = std::min(e, count);
+  if (b < 0 || b >= e) {
+    return false;
+  }
+  first = static_cast<std::size_t>(b);
+  last = static_cast<std::size_t>(e);
+  return true;
+}
+
+// Returns true if negative indices require the number of array elements.
+bool path::step::needs_size() const noexcept
+{
+  return (kind == index || kind == slice) && (begin < 0 || end < 0);
+}
+
+void path::compile_pointer()
+{
+  auto size = expression_.size();
+  std::size_t pos = 0;
+  while (pos < size) {
+    step s;
+    for (++pos; pos < size && expression_[pos] != '/'; ++pos) {
+      auto c = expression_[pos];
+      if (c == '~') {
+        if (pos + 1 == size || (expression_[pos + 1] != '0' && expression_[pos + 1] != '1')) {
+          throw error(expression_, pos);
+        }
+        c = expression_[++pos] == '0' ? '~' : '/';
+      }
+      s.key += c;
+    }
+    s.begin = to_index(s.key);
+    steps_.push_back(std::move(s));
+  }
+}
+
+void path::compile_path()
+{
+  auto size = expression_.size();
+  auto read_integer = [&](std::size_t& pos, std::int64_t& v) {
+    auto negative = pos < size && expression_[pos] == '-';
+    if (negative) {
+      ++pos;
+    }
+    auto begin = pos;
+    v = 0;
+    for (; pos < size && expression_[pos] >= '0' && expression_[pos] <= '9'; ++pos) {
+      if (pos - begin == max_index_digits) {
+        throw error(expression_, pos);
+      }
+      v = v * 10 + (expression_[pos] - '0');
+    }
+    if (negative && pos == begin) {
+      throw error(expression_, pos);
+    }
+    if (negative) {
+      v = -v;
+    }
+    return pos != begin;
+  };
+  std::size_t pos = 1;
+  while (pos < size) {
+    step s;
+    s.begin = -1;
+    if (expression_[pos] == '.') {
+      if (++pos < size && expression_[pos] == '*') {
+        s.kind = step::all;
+        ++pos;
+      } else {
+        auto begin = pos;
+        while (pos < size && expression_[pos] != '.' && expression_[pos] != '[') {
+          ++pos;
+        }
+        if (pos == begin) {
+          throw error(expression_, pos);
+        }
+        s.key.assign(expression_, begin, pos - begin);
+      }
+    } else if (expression_[pos] == '[') {
+      ++pos;
+      if (pos < size && expression_[pos] == '*') {
+        s.kind = step::all;
+        ++pos;
+      } else if (pos < size && (expression_[pos] == '\'' || expression_[pos] == '"')) {
+        auto quote = expression_[pos++];
+        for (; pos < size && expression_[pos] != quote; ++pos) {
+          if (expression_[pos] == '\\' && pos + 1 < size) {
+            ++pos;
+          }
+          s.key += expression_[pos];
+        }
+        if (pos == size) {
+          throw error(expression_, pos);
+        }
+        ++pos;
+      } else {
+        s.kind = step::index;
+        s.has_begin = read_integer(pos, s.begin);
+        if (pos < size && expression_[pos] == ':') {
+          s.kind = step::slice;
+          s.has_end = read_integer(++pos, s.end);
+        } else if (!s.has_begin) {
+          throw error(expression_, pos);
+        }
+      }
+      if (pos == size || expression_[pos] != ']') {
+        throw error(expression_, pos);
+      }
+      ++pos;
+    } else {
+      throw error(expression_, pos);
+    }
+    steps_.push_back(std::move(s));
+  }
+}
+
+template <typename Value, typename Visitor>
+bool path::select(const step* it, const step* end, Value& node, Visitor& visitor)
+{
+  if (it == end) {
+    return visitor(node);
+  }
+  const auto& s = *it++;
+  switch (node.type()) {
+  case json::type::object:
+    if (s.kind == step::all) {
+      for (auto& e : node) {
+        if (!select(it, end, e.value, visitor)) {
+          return false;
+        }
+      }
+    } else if (s.kind == step::name) {
+      auto e = node.find(s.key);
+      if (e != node.end()) {
+        return select(it, end, e->value, visitor);
+      }
+    }
+    return true;
+  case json::type::array: {
+    std::size_t first = 0;
+    std::size_t last = 0;
+    if (!s.range(node.size(), first, last)) {
+      return true;
+    }
+    auto begin = node.begin();
+    for (auto i = first; i < last; i++) {
+      if (!select(it, end, (begin + static_cast<std::ptrdiff_t>(i))->value, visitor)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  default: return true;
+  }
+}
+
+// Arrays are only scanned up to the last selected element, unless negative indices require their size.
+template <typename Visitor>
+bool path::select(const step* it, const step* end, const view& node, Visitor& visitor)
+{
+  if (it == end) {
+    return visitor(node);
+  }
+  const auto& s = *it++;
+  switch (node.type()) {
+  case json::type::object:
+    if (s.kind == step::all) {
+      for (const auto& e : node) {
+        if (!select(it, end, e, visitor)) {
+          return false;
+        }
+      }
+    } else if (s.kind == step::name) {
+      const auto e = node.find(s.key);
+      if (e) {
+        return select(it, end, e, visitor);
+      }
+    }
+    return true;
+  case json::type::array: {
+    std::size_t first = 0;
+    std::size_t last = 0;
+    auto size = s.needs_size() ? node.size() : std::numeric_limits<std::size_t>::max();
+    if (!s.range(size, first, last)) {
+      return true;
+    }
+    std::size_t i = 0;
+    for (auto e = node.begin(); e != node.end(); ++e, ++i) {
+      if (i >= first && !select(it, end, *e, visitor)) {
+        return false;
+      }
+      if (i + 1 >= last) {
+        break;
+      }
+    }
+    return true;
+  }
+  default: return true;
+  }
+}
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,874 @@
+#pragma once
+#include <ice/json/exception.h>
+#include <ice/json/index.h>
+#include <ice/json/number.h>
+#include <ice/json/types.h>
+#include <ice/string_view.h>
+#include <ice/utf8.h>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace ice {
+namespace json {
+namespace detail {
+
+// Character classes used by the contiguous buffer reader.
+enum : std::uint8_t {
+  char_space = 0x01,   // whitespace
+  char_number = 0x02,  // characters that can be part of a number
+  char_string = 0x04,  // characters that can be copied from a string without further processing
+  char_nested = 0x08,  // characters that start or end a string, comment, array or object
+};
+
+struct char_table {
+  std::uint8_t data[256];
+
+  constexpr char_table() : data()
+  {
+    for (int i = 0; i < 256; i++) {
+      std::uint8_t flags = 0;
+      switch (i) {
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+      case '\v':
+      case '\f':
+        flags |= char_space;
+        break;
+      }
+      if ((i >= '0' && i <= '9') || i == '-' || i == '+' || i == '.' || i == 'e' || i == 'E') {
+        flags |= char_number;
+      }
+      if (i < 0x80 && i != '"' && i != '\\') {
+        flags |= char_string;
+      }
+      if (i == '"' || i == '/' || i == '[' || i == ']' || i == '{' || i == '}') {
+        flags |= char_nested;
+      }
+      data[i] = flags;
+    }
+  }
+};
+
+constexpr char_table char_flags;
+
+inline bool is_char(char c, std::uint8_t flags)
+{
+  return (char_flags.data[static_cast<unsigned char>(c)] & flags) != 0;
+}
+
+inline std::uint16_t hex_digit(char c)
+{
+  switch (c) {
+  case '0': return 0x0;
+  case '1': return 0x1;
+  case '2': return 0x2;
+  case '3': return 0x3;
+  case '4': return 0x4;
+  case '5': return 0x5;
+  case '6': return 0x6;
+  case '7': return 0x7;
+  case '8': return 0x8;
+  case '9': return 0x9;
+  case 'a':
+  case 'A': return 0xA;
+  case 'b':
+  case 'B': return 0xB;
+  case 'c':
+  case 'C': return 0xC;
+  case 'd':
+  case 'D': return 0xD;
+  case 'e':
+  case 'E': return 0xE;
+  case 'f':
+  case 'F': return 0xF;
+  }
+  return 0xFF;
+}
+
+// Skips whitespace and '//' comments. Stops at a single '/', which is reported as a syntax error by the caller.
+inline const char* skip_space(const char* it, const char* end)
+{
+  while (it != end) {
+    if (is_char(*it, detail::char_space)) {
+      ++it;
+      continue;
+    }
+    if (*it != '/' || end - it < 2 || it[1] != '/') {
+      break;
+    }
+    while (it != end && *it != '\n') {
+      ++it;
+    }
+  }
+  return it;
+}
+
+// Returns the position after the closing quote of the string that starts at the given quote.
+// Returns nullptr if the string is not terminated.
+inline const char* skip_string(const char* it, const char* end)
+{
+  ++it;
+  while (true) {
+    auto quote = static_cast<const char*>(std::memchr(it, '"', static_cast<std::size_t>(end - it)));
+    if (!quote) {
+      return nullptr;
+    }
+    auto escaped = false;
+    for (auto pos = quote; pos != it && pos[-1] == '\\'; --pos) {
+      escaped = !escaped;
+    }
+    it = quote + 1;
+    if (!escaped) {
+      return it;
+    }
+  }
+}
+
+// Ignores all reader events. Used to skip values and as a base for handlers that only expect some events.
+struct skipper {
+  bool on_null() { return true; }
+  bool on_boolean(boolean) { return true; }
+  bool on_number(number) { return true; }
+  bool on_integer(std::int64_t) { return true; }
+  bool on_string(ice::string_view) { return true; }
+  bool on_key(ice::string_view) { return true; }
+  bool on_start_array() { return true; }
+  bool on_end_array() { return true; }
+  bool on_start_object() { return true; }
+  bool on_end_object() { return true; }
+};
+
+// Selects the reader constructor that decodes escaped strings in place.
+struct in_situ_t {};
+constexpr in_situ_t in_situ{};
+
+// Parses a single json value from a contiguous buffer and reports it to the handler.
+// The handler must implement the following member functions, which return false to stop parsing:
+//   bool on_null();
+//   bool on_boolean(json::boolean v);
+//   bool on_number(json::number v);
+//   bool on_integer(std::int64_t v);  // integers that can not be represented by a double exactly
+//   bool on_string(ice::string_view v);
+//   bool on_key(ice::string_view v);
+//   bool on_start_array();
+//   bool on_end_array();
+//   bool on_start_object();
+//   bool on_end_object();
+// String views are only valid until the handler function returns.
+template <typename Handler>
+class reader {
+public:
+  // Error positions are reported relative to 'line', which is the line number of the first input byte.
+  reader(const char* data, std::size_t size, Handler& handler, std::size_t line = 1) :
+    begin_(data), end_(data + size), it_(data), origin_(data), line_(line), handler_(handler)
+  {}
+
+  // Reads a value from a mutable buffer. Escaped strings are decoded in place and overwrite the buffer, so that string
+  // views always point into the buffer.
+  reader(char* data, std::size_t size, Handler& handler, in_situ_t, std::size_t line = 1) :
+    begin_(data), end_(data + size), it_(data), origin_(data), line_(line), handler_(handler), in_situ_(true)
+  {}
+
+  // Reads a value inside a larger buffer. Error positions are reported relative to 'origin'.
+  reader(const char* origin, const char* data, std::size_t size, Handler& handler) :
+    begin_(data), end_(data + size), it_(data), origin_(origin), handler_(handler)
+  {}
+
+  // Parses the next json value and returns the number of bytes consumed.
+  // Stops after the current token if a handler function returns false (see 'stopped()').
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  std::size_t parse()
+  {
+    if (end_ - it_ >= 3 && it_[0] == '\xEF' && it_[1] == '\xBB' && it_[2] == '\xBF') {
+      it_ += 3;
+    }
+    skip_space();
+    if (it_ == end_) {
+      throw error("incomplete input");
+    }
+    stack_.clear();
+    stopped_ = false;
+    while (!stopped_) {
+      // Expecting a value.
+      if (read_value()) {
+        continue;
+      }
+      // Expecting ',' or the end of the current container.
+      while (!stopped_) {
+        if (stack_.empty()) {
+          return static_cast<std::size_t>(it_ - begin_);
+        }
+        skip_space();
+        if (it_ == end_) {
+          throw error("incomplete input");
+        }
+        auto c = *it_;
+        if (stack_.back() == '[') {
+          if (c == ']') {
+            ++it_;
+            stack_.pop_back();
+            stopped_ = !handler_.on_end_array();
+            continue;
+          }
+          if (c != ',') {
+            throw error("invalid array syntax");
+          }
+          ++it_;
+          skip_space();
+          if (it_ != end_ && *it_ == ']') {
+            ++it_;
+            stack_.pop_back();
+            stopped_ = !handler_.on_end_array();
+            continue;
+          }
+          break;
+        }
+        if (c == '}') {
+          ++it_;
+          stack_.pop_back();
+          stopped_ = !handler_.on_end_object();
+          continue;
+        }
+        if (c != ',') {
+          throw error("invalid object syntax");
+        }
+        ++it_;
+        skip_space();
+        if (it_ != end_ && *it_ == '}') {
+          ++it_;
+          stack_.pop_back();
+          stopped_ = !handler_.on_end_object();
+          continue;
+        }
+        read_key();
+        break;
+      }
+      skip_space();
+    }
+    return static_cast<std::size_t>(it_ - begin_);
+  }
+
+  // Parses the next json value using a structural index of the buffer and returns the number of bytes consumed.
+  // Whitespace is skipped by jumping from one indexed token to the next. If indexing is aborted, parsing continues
+  // without the index from the current position.
+  // Stops after the current token if a handler function returns false (see 'stopped()').
+  // Throws 'ice::json::parse_error' on invalid or incomplete input.
+  std::size_t parse(structural_index& index)
+  {
+    stack_.clear();
+    stopped_ = false;
+    while (!stopped_) {
+      // Expecting a value.
+      if (read_value(index)) {
+        continue;
+      }
+      // Expecting ',' or the end of the current container.
+      while (!stopped_) {
+        if (stack_.empty()) {
+          return static_cast<std::size_t>(it_ - begin_);
+        }
+        auto c = next_token(index);
+        if (stack_.back() == '[') {
+          if (c == ']') {
+            ++it_;
+            stack_.pop_back();
+            stopped_ = !handler_.on_end_array();
+            continue;
+          }
+          if (c != ',') {
+            throw error("invalid array syntax");
+          }
+          ++it_;
+          if (next_token(index, ']')) {
+            stack_.pop_back();
+            stopped_ = !handler_.on_end_array();
+            continue;
+          }
+          break;
+        }
+        if (c == '}') {
+          ++it_;
+          stack_.pop_back();
+          stopped_ = !handler_.on_end_object();
+          continue;
+        }
+        if (c != ',') {
+          throw error("invalid object syntax");
+        }
+        ++it_;
+        if (next_token(index, '}')) {
+          stack_.pop_back();
+          stopped_ = !handler_.on_end_object();
+          continue;
+        }
+        read_key(index);
+        break;
+      }
+    }
+    return static_cast<std::size_t>(it_ - begin_);
+  }
+
+  // Returns true if the last call to 'parse()' was stopped by the handler.
+  bool stopped() const
+  {
+    return stopped_;
+  }
+
+  // Returns the current read position.
+  const char* position() const
+  {
+    return it_;
+  }
+
+private:
+  // Reads a json value. Returns true if the value is an array or object that was opened but not closed.
+  bool read_value()
+  {
+    if (it_ == end_) {
+      throw error("incomplete input");
+    }
+    switch (*it_) {
+    case '[':
+      ++it_;
+      if (!handler_.on_start_array()) {
+        stopped_ = true;
+        return false;
+      }
+      skip_space();
+      if (it_ != end_ && *it_ == ']') {
+        ++it_;
+        stopped_ = !handler_.on_end_array();
+        return false;
+      }
+      stack_.push_back('[');
+      return true;
+    case '{':
+      ++it_;
+      if (!handler_.on_start_object()) {
+        stopped_ = true;
+        return false;
+      }
+      skip_space();
+      if (it_ != end_ && *it_ == '}') {
+        ++it_;
+        stopped_ = !handler_.on_end_object();
+        return false;
+      }
+      stack_.push_back('{');
+      read_key();
+      return true;
+    case '"':
+      stopped_ = !handler_.on_string(read_string());
+      return false;
+    case 'n':
+      read_literal("null", 4);
+      stopped_ = !handler_.on_null();
+      return false;
+    case 't':
+      read_literal("true", 4);
+      stopped_ = !handler_.on_boolean(true);
+      return false;
+    case 'f':
+      read_literal("false", 5);
+      stopped_ = !handler_.on_boolean(false);
+      return false;
+    case '-':
+    case '.':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      stopped_ = !on_number(read_number());
+      return false;
+    }
+    throw error("syntax error");
+  }
+
+  // Moves the read position to the next indexed token and returns the token character.
+  char next_token(structural_index& index)
+  {
+    std::uint32_t offset = 0;
+    if (index.next(offset)) {
+      it_ = begin_ + offset;
+      return *it_;
+    }
+    if (index.aborted()) {
+      skip_space();
+    } else {
+      it_ = end_;
+    }
+    if (it_ == end_) {
+      throw error("incomplete input");
+    }
+    return *it_;
+  }
+
+  // Moves the read position past the next indexed token if it is the given character.
+  bool next_token(structural_index& index, char c)
+  {
+    std::uint32_t offset = 0;
+    if (index.peek(offset)) {
+      if (begin_[offset] != c) {
+        return false;
+      }
+      index.next(offset);
+      it_ = begin_ + offset + 1;
+      return true;
+    }
+    if (index.aborted()) {
+      skip_space();
+      if (it_ != end_ && *it_ == c) {
+        ++it_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Reads a json value using the structural index.
+  // Returns true if the value is an array or object that was opened but not closed.
+  bool read_value(structural_index& index)
+  {
+    switch (next_token(index)) {
+    case '[':
+      ++it_;
+      if (!handler_.on_start_array()) {
+        stopped_ = true;
+        return false;
+      }
+      if (next_token(index, ']')) {
+        stopped_ = !handler_.on_end_array();
+        return false;
+      }
+      stack_.push_back('[');
+      return true;
+    case '{':
+      ++it_;
+      if (!handler_.on_start_object()) {
+        stopped_ = true;
+        return false;
+      }
+      if (next_token(index, '}')) {
+        stopped_ = !handler_.on_end_object();
+        return false;
+      }
+      stack_.push_back('{');
+      read_key(index);
+      return true;
+    case '"':
+      stopped_ = !handler_.on_string(read_string(index));
+      return false;
+    case 'n':
+      read_literal("null", 4);
+      read_token_end();
+      stopped_ = !handler_.on_null();
+      return false;
+    case 't':
+      read_literal("true", 4);
+      read_token_end();
+      stopped_ = !handler_.on_boolean(true);
+      return false;
+    case 'f':
+      read_literal("false", 5);
+      read_token_end();
+      stopped_ = !handler_.on_boolean(false);
+      return false;
+    case '-':
+    case '.':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    {
+      auto v = read_number();
+      read_token_end();
+      stopped_ = !on_number(v);
+    }
+      return false;
+    }
+    throw error("syntax error");
+  }
+
+  // Reads an object key and the following ':' character using the structural index.
+  void read_key(structural_index& index)
+  {
+    if (next_token(index) != '"') {
+      throw error("invalid object syntax");
+    }
+    if (!handler_.on_key(read_string(index))) {
+      stopped_ = true;
+      return;
+    }
+    if (next_token(index) != ':') {
+      throw error("invalid object syntax");
+    }
+    ++it_;
+  }
+
+  // Reads a string using the structural index, which also contains the closing quote.
+  ice::string_view read_string(structural_index& index)
+  {
+    auto open = static_cast<std::uint32_t>(it_ - begin_);
+    std::uint32_t close = 0;
+    if (!index.next(close)) {
+      if (index.aborted()) {
+        return read_string();
+      }
+      throw error("incomplete input");
+    }
+    if (!index.clean(open, close)) {
+      return read_string();
+    }
+    it_ = begin_ + close + 1;
+    return { begin_ + open + 1, static_cast<std::size_t>(close - open - 1) };
+  }
+
+  // Makes sure that a number or literal inside a container is not followed by other characters.
+  // Everything between indexed tokens is whitespace, unless the previous token is a number or literal.
+  void read_token_end()
+  {
+    if (stack_.empty() || it_ == end_ || is_char(*it_, char_space)) {
+      return;
+    }
+    switch (*it_) {
+    case ',':
+    case ']':
+    case '}':
+    case '/':
+      return;
+    }
+    throw error("syntax error");
+  }
+
+  // Reads an object key and the following ':' character.
+  void read_key()
+  {
+    if (it_ == end_) {
+      throw error("incomplete input");
+    }
+    if (*it_ != '"') {
+      throw error("invalid object syntax");
+    }
+    if (!handler_.on_key(read_string())) {
+      stopped_ = true;
+      return;
+    }
+    skip_space();
+    if (it_ == end_) {
+      throw error("incomplete input");
+    }
+    if (*it_ != ':') {
+      throw error("invalid object syntax");
+    }
+    ++it_;
+    skip_space();
+  }
+
+  // Reads a string starting with '"'. Strings without escape sequences are returned as views into the input buffer.
+  // Other strings are decoded into the reader buffer or in place (see 'in_situ').
+  ice::string_view read_string()
+  {
+    auto begin = ++it_;
+    while (true) {
+      while (it_ != end_ && is_char(*it_, char_string)) {
+        ++it_;
+      }
+      if (it_ == end_) {
+        throw error("incomplete input");
+      }
+      auto c = *it_;
+      if (c == '"') {
+        return { begin, static_cast<std::size_t>(it_++ - begin) };
+      }
+      if (c == '\\') {
+        break;
+      }
+      read_utf8();
+    }
+    if (in_situ_) {
+      return read_string_in_situ(begin);
+    }
+    buffer_.assign(begin, it_);
+    char data[4];
+    while (true) {
+      auto run = it_;
+      while (it_ != end_ && is_char(*it_, char_string)) {
+        ++it_;
+      }
+      buffer_.append(run, it_);
+      if (it_ == end_) {
+        throw error("incomplete input");
+      }
+      switch (*it_) {
+      case '"':
+        ++it_;
+        return { buffer_.data(), buffer_.size() };
+      case '\\':
+        buffer_.append(data, read_escape(data));
+        break;
+      default:
+        run = it_;
+        read_utf8();
+        buffer_.append(run, it_);
+        break;
+      }
+    }
+  }
+
+  // Decodes the rest of a string starting with an escape sequence in place.
+  // Decoded characters never overtake the read position, because escape sequences are longer than their characters.
+  ice::string_view read_string_in_situ(const char* begin)
+  {
+    auto out = const_cast<char*>(it_);
+    while (true) {
+      auto run = it_;
+      while (it_ != end_ && is_char(*it_, char_string)) {
+        ++it_;
+      }
+      if (out != run) {
+        std::memmove(out, run, static_cast<std::size_t>(it_ - run));
+      }
+      out += it_ - run;
+      if (it_ == end_) {
+        throw error("incomplete input");
+      }
+      switch (*it_) {
+      case '"':
+        ++it_;
+        return { begin, static_cast<std::size_t>(out - begin) };
+      case '\\': {
+        char data[4];
+        auto size = read_escape(data);
+        if (data[0] == '\n') {
+          newlines_.push_back(out);
+        }
+        std::memcpy(out, data, size);
+        out += size;
+        break;
+      }
+      default:
+        run = it_;
+        read_utf8();
+        std::memmove(out, run, static_cast<std::size_t>(it_ - run));
+        out += it_ - run;
+        break;
+      }
+    }
+  }
+
+  // Validates a multi-byte UTF-8 sequence.
+  void read_utf8()
+  {
+    auto it = reinterpret_cast<const std::uint8_t*>(it_);
+    auto end = reinterpret_cast<const std::uint8_t*>(end_);
+    if (utf8::internal::validate_next(it, end) != utf8::internal::UTF8_OK) {
+      throw error("invalid UTF-8");
+    }
+    it_ = reinterpret_cast<const char*>(it);
+  }
+
+  // Decodes an escape sequence starting with '\\' into the given characters and returns their number (at most 4).
+  std::size_t read_escape(char* data)
+  {
+    if (end_ - it_ < 2) {
+      throw error("incomplete input");
+    }
+    ++it_;
+    switch (*it_++) {
+    case '"': data[0] = '"'; return 1;
+    case '\\': data[0] = '\\'; return 1;
+    case '/': data[0] = '/'; return 1;
+    case 'b': data[0] = '\b'; return 1;
+    case 'f': data[0] = '\f'; return 1;
+    case 'n': data[0] = '\n'; return 1;
+    case 'r': data[0] = '\r'; return 1;
+    case 't': data[0] = '\t'; return 1;
+    case 'u': break;
+    default: --it_; throw error("syntax error");
+    }
+    char16_t w[2] = {};
+    w[0] = read_utf16();
+    std::size_t size = 1;
+    if (w[0] > 0xD7FF && w[0] < 0xE000) {
+      if (end_ - it_ < 2) {
+        throw error("incomplete input");
+      }
+      if (it_[0] != '\\' || it_[1] != 'u') {
+        throw error("invalid UTF-16 escape sequence");
+      }
+      it_ += 2;
+      w[1] = read_utf16();
+      size = 2;
+    }
+    try {
+      return static_cast<std::size_t>(utf8::utf16to8(w, w + size, data) - data);
+    }
+    catch (...) {
+      throw error("invalid UTF-16");
+    }
+  }
+
+  // Reads four hexadecimal digits of a UTF-16 escape sequence.
+  char16_t read_utf16()
+  {
+    if (end_ - it_ < 4) {
+      throw error("incomplete input");
+    }
+    std::uint16_t w = 0;
+    for (auto i = 0; i < 4; i++) {
+      auto c = hex_digit(*it_);
+      if (c == 0xFF) {
+        throw error("invalid UTF-16 escape sequence");
+      }
+      w = static_cast<std::uint16_t>((w << 4) | c);
+      ++it_;
+    }
+    return static_cast<char16_t>(w);
+  }
+
+  number_token read_number()
+  {
+    auto begin = it_;
+    while (it_ != end_ && is_char(*it_, char_number)) {
+      ++it_;
+    }
+    number_token v;
+    if (!to_number(begin, static_cast<std::size_t>(it_ - begin), v)) {
+      it_ = begin;
+      throw error("invalid number");
+    }
+    return v;
+  }
+
+  bool on_number(const number_token& v)
+  {
+    return v.is_integer ? handler_.on_integer(v.integer) : handler_.on_number(v.real);
+  }
+
+  void read_literal(const char* literal, std::size_t size)
+  {
+    for (std::size_t i = 0; i < size; i++) {
+      if (it_ == end_) {
+        throw error("incomplete input");
+      }
+      if (*it_ != literal[i]) {
+        throw error("syntax error");
+      }
+      ++it_;
+    }
+  }
+
+  // Skips whitespace and '//' comments.
+  void skip_space()
+  {
+    while (it_ != end_) {
+      if (is_char(*it_, char_space)) {
+        ++it_;
+        continue;
+      }
+      if (*it_ != '/') {
+        return;
+      }
+      if (end_ - it_ < 2 || it_[1] != '/') {
+        throw error("syntax error");
+      }
+      while (it_ != end_ && *it_ != '\n') {
+        ++it_;
+      }
+    }
+  }
+
+  // Creates a parse error with the line and column of the current read position.
+  parse_error error(const char* message) const
+  {
+    auto line = line_;
+    std::size_t column = 0;
+    auto decoded = newlines_.begin();
+    for (auto it = origin_; it != it_ && it != end_; ++it) {
+      if (*it == '\n') {
+        if (decoded != newlines_.end() && *decoded == it) {
+          ++decoded;
+        } else {
+          line++;
+          column = 0;
+        }
+      }
+      column++;
+    }
+    std::ostringstream oss;
+    oss << message << " (line " << line << " column " << column + 1;
+    if (it_ != end_) {
+      auto c = *it_;
+      if (c >= ' ' && c <= '~') {
+        oss << " '" << c << "'";
+      } else {
+        oss << " '" << (static_cast<unsigned int>(c) & 0xFF) << "'";
+      }
+    }
+    oss << ")";
+    return oss.str();
+  }
+
+  const char* begin_;
+  const char* end_;
+  const char* it_;
+  const char* origin_;
+  std::size_t line_ = 1;  // line number of 'origin_'
+  Handler& handler_;
+  std::vector<char> stack_;
+  std::string buffer_;
+  std::vector<const char*> newlines_;  // newline characters decoded in place, which do not start input lines
+  bool in_situ_ = false;
+  bool stopped_ = false;
+};
+
+// Parses a single json value from a contiguous buffer and reports it to the handler.
+// Large buffers are parsed with a structural index. Returns false if the handler stopped parsing.
+template <typename Handler>
+inline bool read(const char* data, std::size_t size, Handler& handler)
+{
+  reader<Handler> parser(data, size, handler);
+  if (size >= index_threshold && structural_index::supported(size)) {
+    structural_index index(data, size);
+    parser.parse(index);
+  } else {
+    parser.parse();
+  }
+  return !parser.stopped();
+}
+
+// Parses a single json value from a mutable buffer and decodes escaped strings in place.
+template <typename Handler>
+inline bool read(char* data, std::size_t size, Handler& handler, in_situ_t)
+{
+  reader<Handler> parser(data, size, handler, in_situ);
+  if (size >= index_threshold && structural_index::supported(size)) {
+    structural_index index(data, size);
+    parser.parse(index);
+  } else {
+    parser.parse();
+  }
+  return !parser.stopped();
+}
+
+}  // namespace detail
+}  // namespace json
+}  // namespace ice
@@ -1,11 +1,127 @@
 #include <ice/json/types.h>
 #include <ice/json/exception.h>
 #include <ice/json/value.h>
+#include <new>
 #include <sstream>
 
 namespace ice {
 namespace json {
 
+name::name(const name& other) : data_(0)
+{
+  if (other) {
+    *this = *other;
+  }
+}
+
+name::name(std::string value) : name(std::move(value), json::allocator<std::string>())
+{}
+
+name::name(std::string value, const json::allocator<std::string>& allocator)
+{
+  auto arena = allocator.arena();
+  auto memory = arena ? arena->allocate(sizeof(std::string), alignof(std::string)) : ::operator new(sizeof(std::string));
+  data_ = reinterpret_cast<std::uintptr_t>(new (memory) std::string(std::move(value))) | (arena ? 1 : 0);
+}
+
+name& name::operator=(name&& other) noexcept
+{
+  if (this != &other) {
+    reset();
+    data_ = other.data_;
+    other.data_ = 0;
+  }
+  return *this;
+}
+
+name& name::operator=(const name& other)
+{
+  if (!other) {
+    reset();
+    return *this;
+  }
+  return *this = *other;
+}
+
+name& name::operator=(std::string value)
+{
+  if (data_ && !(data_ & 2)) {
+    *get() = std::move(value);
+  } else {
+    *this = name(std::move(value));
+  }
+  return *this;
+}
+
+std::string& name::value()
+{
+  if (!data_) {
+    throw bad_optional_access("bad optional access");
+  }
+  return *detach();
+}
+
+const std::string& name::value() const
+{
+  if (!data_) {
+    throw bad_optional_access("bad optional access");
+  }
+  return *get();
+}
+
+std::string* name::detach()
+{
+  if (data_ & 2) {
+    *this = name(*get());
+  }
+  return get();
+}
+
+void name::reset() noexcept
+{
+  if (data_ & 2) {
+    data_ = 0;
+  } else if (data_) {
+    auto p = get();
+    p->~basic_string();
+    if (!(data_ & 1)) {
+      ::operator delete(p);
+    }
+    data_ = 0;
+  }
+}
+
+std::string name::take()
+{
+  if (!data_) {
+    throw bad_optional_access("bad optional access");
+  }
+  auto s = data_ & 2 ? *get() : std::move(*get());
+  reset();
+  return s;
+}
+
+bool operator==(const name& a, const name& b)
+{
+  if (a && b) {
+    return &*a == &*b || *a == *b;
+  }
+  return !a && !b;
+}
+
+bool operator!=(const name& a, const name& b)
+{
+  return !(a == b);
+}
+
+bool operator<(const name& a, const name& b)
+{
+  if (a && b) {
+    return *a < *b;
+  }
+  return !a && b;
+}
+
 std::ostream& operator<<(std::ostream& os, json::type type)
 {
   switch (type) {
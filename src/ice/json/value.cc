@@ -1,34 +1,55 @@
 #include <ice/json/format.h>
+#include <ice/json/number.h>
 #include <ice/json/traits.h>
 #include <ice/json/value.h>
 #include <algorithm>
+#include <limits>
 #include <sstream>
+#include <cstddef>
+#include <cstring>
 
 namespace ice {
 namespace json {
+namespace {
 
-value::value(value&& other) : type_(other.type_)
+// Integers up to 2^53 are exact as a double.
+constexpr std::int64_t max_exact = std::int64_t(1) << 53;
+
+// Doubles at or beyond 2^63 do not fit into a 64-bit integer.
+constexpr number max_integer = 9223372036854775808.0;
+
+// Converts a double that holds a rounded 64-bit integer to the integer modulo 2^64. The double may be rounded up to 2^63.
+std::uint64_t to_unsigned(number v) noexcept
 {
-  switch (type_) {
-  case json::type::null: break;
-  case json::type::boolean: data_.boolean = other.data_.boolean; break;
-  case json::type::number: data_.number = other.data_.number; break;
-  case json::type::string: new (&data_.string) string(std::move(other.data_.string)); break;
-  case json::type::array: new (&data_.array) array(std::move(other.data_.array)); break;
-  case json::type::object: new (&data_.object) object(std::move(other.data_.object)); break;
-  }
+  return v < 0 ? 0 - static_cast<std::uint64_t>(-v) : static_cast<std::uint64_t>(v);
 }
 
-value::value(const value& other) : type_(other.type_)
+// Returns the exact integer minus the double for numbers that keep an exact integer and 0 for other numbers. Numbers
+// with equal doubles are ordered by this difference, because 'as_integer()' clamps the double 2^63.
+std::int64_t rounding(const value& v) noexcept
 {
-  switch (type_) {
-  case json::type::null: break;
-  case json::type::boolean: data_.boolean = other.data_.boolean; break;
-  case json::type::number: data_.number = other.data_.number; break;
-  case json::type::string: new (&data_.string) string(other.data_.string); break;
-  case json::type::array: new (&data_.array) array(other.data_.array); break;
-  case json::type::object: new (&data_.object) object(other.data_.object); break;
+  if (!v.has_integer()) {
+    return 0;
   }
+  return static_cast<std::int64_t>(static_cast<std::uint64_t>(v.as_integer()) - to_unsigned(v.data<number>()));
+}
+
+}  // namespace
+
+static_assert(sizeof(value) == 16, "json values must stay 16 bytes");
+
+value::value(value&& other) noexcept :
+  data_(other.data_), rounding_(other.rounding_), type_(other.type_), flags_(other.flags_)
+{
+  static_assert(offsetof(value, type_) == short_size, "short strings must end before the json value type");
+  std::memcpy(chars_, other.chars_, sizeof(chars_));
+  other.type_ = json::type::null;
+  other.flags_ = 0;
+}
+
+value::value(const value& other) : type_(json::type::null)
+{
+  *this = other;
 }
 
 value::value(std::initializer_list<value> list)
@@ -56,15 +77,24 @@ value::~value()
   reset();
 }
 
-value& value::operator=(value&& other)
+value& value::operator=(value&& other) noexcept
 {
-  switch (other.type_) {
-  case json::type::null: reset(); break;
-  case json::type::boolean: reset(other.data_.boolean); break;
-  case json::type::number: reset(other.data_.number); break;
-  case json::type::string: reset(std::move(other.data_.string)); break;
-  case json::type::array: reset(std::move(other.data_.array)); break;
-  case json::type::object: reset(std::move(other.data_.object)); break;
+  if (this != &other) {
+    // The other value may be owned by this value.
+    auto data = other.data_;
+    auto type = other.type_;
+    auto flags = other.flags_;
+    auto rounding = other.rounding_;
+    char chars[sizeof(chars_)];
+    std::memcpy(chars, other.chars_, sizeof(chars_));
+    other.type_ = json::type::null;
+    other.flags_ = 0;
+    reset();
+    data_ = data;
+    type_ = type;
+    flags_ = flags;
+    rounding_ = rounding;
+    std::memcpy(chars_, chars, sizeof(chars_));
   }
   return *this;
 }
@@ -74,10 +104,30 @@ value& value::operator=(const value& other)
   switch (other.type_) {
   case json::type::null: reset(); break;
   case json::type::boolean: reset(other.data_.boolean); break;
-  case json::type::number: reset(other.data_.number); break;
-  case json::type::string: reset(other.data_.string); break;
-  case json::type::array: reset(other.data_.array); break;
-  case json::type::object: reset(other.data_.object); break;
+  case json::type::number:
+    if (other.flags_ & integer_flag) {
+      reset(other.as_integer());
+    } else {
+      reset(other.data_.number);
+    }
+    break;
+  case json::type::string:
+    if (other.flags_ & short_flag) {
+      auto v = other.text();
+      reset_short(v.data(), v.size());
+    } else {
+      auto v = other.text();
+      reset(string(v.data(), v.size()));
+    }
+    break;
+  case json::type::array:
+    if (other.flags_ & packed_flag) {
+      reset(numbers(*other.data_.numbers));
+    } else {
+      reset(array(*other.data_.array));
+    }
+    break;
+  case json::type::object: reset(object(*other.data_.object)); break;
   }
   return *this;
 }
@@ -90,8 +140,8 @@ json::type value::type() const
 bool value::empty() const noexcept
 {
   switch (type_) {
-  case json::type::array: return data_.array.empty();
-  case json::type::object: return data_.object.empty();
+  case json::type::array: return (flags_ & packed_flag) ? data_.numbers->empty() : data_.array->empty();
+  case json::type::object: return members().empty();
   default: return true;
   }
 }
@@ -100,8 +150,8 @@ std::size_t value::size() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.size();
-    case json::type::object: return data_.object.size();
+    case json::type::array: return (flags_ & packed_flag) ? data_.numbers->size() : data_.array->size();
+    case json::type::object: return members().size();
     default: return 0;
     }
   }
@@ -114,9 +164,22 @@ void value::clear() noexcept
 {
   try {
     switch (type_) {
-    case json::type::string: data_.string.clear(); break;
-    case json::type::array: data_.array.clear(); break;
-    case json::type::object: data_.object.clear(); break;
+    case json::type::string:
+      if (flags_ & (short_flag | view_flag)) {
+        flags_ = short_flag;
+      } else {
+        data_.string->clear();
+      }
+      break;
+    case json::type::array:
+      if (flags_ & packed_flag) {
+        data_.numbers->release();
+        data_.numbers->clear();
+      } else {
+        data_.array->clear();
+      }
+      break;
+    case json::type::object: data_.object->clear(); break;
     default: break;
     }
   }
@@ -129,10 +192,11 @@ value& value::operator[](std::size_t index)
   if (type_ != json::type::array) {
     throw type_error::access(type_, index);
   }
-  if (data_.array.size() <= index) {
+  auto& elements = this->elements();
+  if (elements.size() <= index) {
     throw range_error::access(index);
   }
-  return data_.array[index].value;
+  return elements[index].value;
 }
 
 const value& value::operator[](std::size_t index) const
@@ -140,10 +204,11 @@ const value& value::operator[](std::size_t index) const
   if (type_ != json::type::array) {
     throw type_error::const_access(type_, index);
   }
-  if (data_.array.size() <= index) {
+  const auto& elements = this->elements();
+  if (elements.size() <= index) {
     throw range_error::const_access(index);
   }
-  return data_.array[index].value;
+  return elements[index].value;
 }
 
 void value::erase(std::size_t index)
@@ -151,48 +216,43 @@ void value::erase(std::size_t index)
   if (type_ != json::type::array) {
     throw type_error::erase(type_, index);
   }
-  if (data_.array.size() <= index) {
+  auto& elements = this->elements();
+  if (elements.size() <= index) {
     throw range_error::access(index);
   }
-  data_.array.erase(data_.array.begin() + index);
+  elements.erase(elements.begin() + index);
 }
 
-value& value::operator[](const std::string& key)
+value& value::operator[](ice::string_view key)
 {
   if (type_ != json::type::object) {
     reset(json::type::object);
   }
-  auto it = std::find_if(data_.object.begin(), data_.object.end(), [&key](auto& e) {
-    return e.name && e.name.value() == key;
-  });
-  if (it == data_.object.end()) {
-    return data_.object.insert(data_.object.end(), { key, ice::json::value() })->value;
+  auto it = data_.object->find(key);
+  if (it == data_.object->cend()) {
+    return data_.object->append(key.to_string(), value());
   }
   return it->value;
 }
 
-const value& value::operator[](const std::string& key) const
+const value& value::operator[](ice::string_view key) const
 {
   if (type_ != json::type::object) {
-    throw type_error::const_access(type_, key);
+    throw type_error::const_access(type_, key.to_string());
   }
-  auto it = std::find_if(data_.object.cbegin(), data_.object.cend(), [&key](auto& e) {
-    return e.name && e.name.value() == key;
-  });
-  if (it == data_.object.end()) {
-    throw range_error::const_access(key);
+  auto it = members().find(key);
+  if (it == members().end()) {
+    throw range_error::const_access(key.to_string());
   }
   return it->value;
 }
 
-iterator value::find(const std::string& key) noexcept
+iterator value::find(ice::string_view key) noexcept
 {
   try {
     if (type_ == json::type::object) {
-      auto it = std::find_if(data_.object.begin(), data_.object.end(), [&key](auto& e) {
-        return e.name && e.name.value() == key;
-      });
-      if (it != data_.object.end()) {
+      auto it = data_.object->find(key);
+      if (it != data_.object->cend()) {
         return it;
       }
     }
@@ -202,14 +262,12 @@ iterator value::find(const std::string& key) noexcept
   return iterator();
 }
 
-const_iterator value::find(const std::string& key) const noexcept
+const_iterator value::find(ice::string_view key) const noexcept
 {
   try {
     if (type_ == json::type::object) {
-      auto it = std::find_if(data_.object.cbegin(), data_.object.cend(), [&key](auto& e) {
-        return e.name && e.name.value() == key;
-      });
-      if (it != data_.object.end()) {
+      auto it = members().find(key);
+      if (it != members().end()) {
         return it;
       }
     }
@@ -219,15 +277,18 @@ const_iterator value::find(const std::string& key) const noexcept
   return iterator();
 }
 
-iterator value::erase(const std::string& key) noexcept
+bool value::contains(ice::string_view key) const noexcept
+{
+  return type_ == json::type::object && members().find(key) != members().end();
+}
+
+iterator value::erase(ice::string_view key) noexcept
 {
   try {
     if (type_ == json::type::object) {
-      auto it = std::find_if(data_.object.cbegin(), data_.object.cend(), [&key](auto& e) {
-        return e.name && e.name.value() == key;
-      });
-      if (it != data_.object.end()) {
-        return data_.object.erase(it);
+      auto it = data_.object->find(key);
+      if (it != data_.object->cend()) {
+        return data_.object->erase(it);
       }
     }
   }
@@ -240,8 +301,8 @@ iterator value::begin() noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.begin();
-    case json::type::object: return data_.object.begin();
+    case json::type::array: return elements().begin();
+    case json::type::object: return data_.object->begin();
     default: return iterator();
     }
   }
@@ -254,8 +315,8 @@ const_iterator value::begin() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.begin();
-    case json::type::object: return data_.object.begin();
+    case json::type::array: return elements().begin();
+    case json::type::object: return members().begin();
     default: return const_iterator();
     }
   }
@@ -268,8 +329,8 @@ const_iterator value::cbegin() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.cbegin();
-    case json::type::object: return data_.object.cbegin();
+    case json::type::array: return elements().cbegin();
+    case json::type::object: return members().cbegin();
     default: return const_iterator();
     }
   }
@@ -282,8 +343,8 @@ iterator value::end() noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.end();
-    case json::type::object: return data_.object.end();
+    case json::type::array: return elements().end();
+    case json::type::object: return data_.object->end();
     default: return iterator();
     }
   }
@@ -296,8 +357,8 @@ const_iterator value::end() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.end();
-    case json::type::object: return data_.object.end();
+    case json::type::array: return elements().end();
+    case json::type::object: return members().end();
     default: return const_iterator();
     }
   }
@@ -310,8 +371,8 @@ const_iterator value::cend() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.cend();
-    case json::type::object: return data_.object.cend();
+    case json::type::array: return elements().cend();
+    case json::type::object: return members().cend();
     default: return const_iterator();
     }
   }
@@ -324,8 +385,8 @@ reverse_iterator value::rbegin() noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.rbegin();
-    case json::type::object: return data_.object.rbegin();
+    case json::type::array: return elements().rbegin();
+    case json::type::object: return data_.object->rbegin();
     default: return reverse_iterator();
     }
   }
@@ -338,8 +399,8 @@ const_reverse_iterator value::rbegin() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.rbegin();
-    case json::type::object: return data_.object.rbegin();
+    case json::type::array: return elements().rbegin();
+    case json::type::object: return members().rbegin();
     default: return const_reverse_iterator();
     }
   }
@@ -352,8 +413,8 @@ const_reverse_iterator value::crbegin() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.crbegin();
-    case json::type::object: return data_.object.crbegin();
+    case json::type::array: return elements().crbegin();
+    case json::type::object: return members().crbegin();
     default: return const_reverse_iterator();
     }
   }
@@ -366,8 +427,8 @@ reverse_iterator value::rend() noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.rend();
-    case json::type::object: return data_.object.rend();
+    case json::type::array: return elements().rend();
+    case json::type::object: return data_.object->rend();
     default: return reverse_iterator();
     }
   }
@@ -380,8 +441,8 @@ const_reverse_iterator value::rend() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.rend();
-    case json::type::object: return data_.object.rend();
+    case json::type::array: return elements().rend();
+    case json::type::object: return members().rend();
     default: return const_reverse_iterator();
     }
   }
@@ -394,8 +455,8 @@ const_reverse_iterator value::crend() const noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.crend();
-    case json::type::object: return data_.object.crend();
+    case json::type::array: return elements().crend();
+    case json::type::object: return members().crend();
     default: return const_reverse_iterator();
     }
   }
@@ -408,8 +469,8 @@ iterator value::erase(iterator it)  noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.erase(it); break;
-    case json::type::object: return data_.object.erase(it); break;
+    case json::type::array: return elements().erase(it); break;
+    case json::type::object: return data_.object->erase(it); break;
     default: return iterator();
     }
   }
@@ -422,8 +483,8 @@ iterator value::erase(const_iterator it) noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.erase(it); break;
-    case json::type::object: return data_.object.erase(it); break;
+    case json::type::array: return elements().erase(it); break;
+    case json::type::object: return data_.object->erase(it); break;
     default: return iterator();
     }
   }
@@ -436,8 +497,8 @@ iterator value::erase(iterator first, iterator last) noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.erase(first, last); break;
-    case json::type::object: return data_.object.erase(first, last); break;
+    case json::type::array: return elements().erase(first, last); break;
+    case json::type::object: return data_.object->erase(first, last); break;
     default: return iterator();
     }
   }
@@ -450,8 +511,8 @@ iterator value::erase(const_iterator first, const_iterator last) noexcept
 {
   try {
     switch (type_) {
-    case json::type::array: return data_.array.erase(first, last); break;
-    case json::type::object: return data_.object.erase(first, last); break;
+    case json::type::array: return elements().erase(first, last); break;
+    case json::type::object: return data_.object->erase(first, last); break;
     default: return iterator();
     }
   }
@@ -464,35 +525,50 @@ void value::reset()
 {
   switch (type_) {
   case json::type::null: return;
-  case json::type::string: data_.string.~string(); break;
-  case json::type::array: data_.array.~array(); break;
-  case json::type::object: data_.object.~object(); break;
+  case json::type::string:
+    if (!(flags_ & (short_flag | view_flag))) {
+      destroy(data_.string);
+    }
+    break;
+  case json::type::array:
+    if (flags_ & packed_flag) {
+      destroy(data_.numbers);
+    } else {
+      destroy(data_.array);
+    }
+    break;
+  case json::type::object: destroy(data_.object); break;
   default: break;
   }
   type_ = json::type::null;
+  flags_ = 0;
 }
 
 void value::reset(json::type type)
 {
   if (type_ == type) {
     switch (type_) {
-    case json::type::string: data_.string.clear(); return;
-    case json::type::array: data_.array.clear(); return;
-    case json::type::object: data_.object.clear(); return;
+    case json::type::string: clear(); return;
+    case json::type::array:
+      if (flags_ & packed_flag) {
+        data_.numbers->release();
+        data_.numbers->clear();
+      } else {
+        data_.array->clear();
+      }
+      return;
+    case json::type::object: data_.object->clear(); return;
     default: break;
     }
-  } else {
-    reset();
   }
   switch (type) {
-  case json::type::null: break;
-  case json::type::boolean: data_.boolean = false; break;
-  case json::type::number: data_.number = 0.0; break;
-  case json::type::string: new (&data_.string) string(); break;
-  case json::type::array: new (&data_.array) array(); break;
-  case json::type::object: new (&data_.object) object(); break;
+  case json::type::null: reset(); break;
+  case json::type::boolean: reset(false); break;
+  case json::type::number: reset(0.0); break;
+  case json::type::string: reset(string()); break;
+  case json::type::array: reset(array()); break;
+  case json::type::object: reset(object()); break;
   }
-  type_ = type;
 }
 
 void value::reset(boolean v)
@@ -509,39 +585,140 @@ void value::reset(number v)
   type_ = json::type::number;
 }
 
+void value::reset(std::int64_t v)
+{
+  reset();
+  data_.number = static_cast<number>(v);
+  type_ = json::type::number;
+  if (v > max_exact || v < -max_exact) {
+    flags_ |= integer_flag;
+    rounding_ = static_cast<std::int16_t>(static_cast<std::uint64_t>(v) - to_unsigned(data_.number));
+  }
+}
+
 void value::reset(string v)
 {
-  if (type_ == json::type::string) {
-    data_.string = std::move(v);
+  if (type_ == json::type::string && !(flags_ & (short_flag | view_flag))) {
+    *data_.string = std::move(v);
   } else {
-    reset();
-    new (&data_.string) string(std::move(v));
-    type_ = json::type::string;
+    reset(std::move(v), json::allocator<string>());
   }
 }
 
+void value::reset(string v, const json::allocator<string>& allocator)
+{
+  if (v.size() <= short_size) {
+    reset_short(v.data(), v.size());
+    return;
+  }
+  auto arena = allocator.arena();
+  auto memory = arena ? arena->allocate(sizeof(string), alignof(string)) : ::operator new(sizeof(string));
+  reset();
+  data_.string = new (memory) string(std::move(v));
+  type_ = json::type::string;
+  flags_ = arena ? arena_flag : 0;
+}
+
 void value::reset(array v)
 {
-  if (type_ == json::type::array) {
-    data_.array = std::move(v);
+  if (type_ == json::type::array && !(flags_ & packed_flag)) {
+    *data_.array = std::move(v);
   } else {
+    auto arena = v.get_allocator().arena();
+    auto memory = arena ? arena->allocate(sizeof(array), alignof(array)) : ::operator new(sizeof(array));
     reset();
-    new (&data_.array) array(std::move(v));
+    data_.array = new (memory) array(std::move(v));
     type_ = json::type::array;
+    flags_ = arena ? arena_flag : 0;
   }
 }
 
 void value::reset(object v)
 {
   if (type_ == json::type::object) {
-    data_.object = std::move(v);
+    *data_.object = std::move(v);
   } else {
+    auto arena = v.get_allocator().arena();
+    auto memory = arena ? arena->allocate(sizeof(object), alignof(object)) : ::operator new(sizeof(object));
     reset();
-    new (&data_.object) object(std::move(v));
+    data_.object = new (memory) object(std::move(v));
     type_ = json::type::object;
+    flags_ = arena ? arena_flag : 0;
   }
 }
 
+void value::reset(numbers v)
+{
+  if (type_ == json::type::array && (flags_ & packed_flag)) {
+    *data_.numbers = std::move(v);
+  } else {
+    auto arena = v.get_allocator().arena();
+    auto memory = arena ? arena->allocate(sizeof(numbers), alignof(numbers)) : ::operator new(sizeof(numbers));
+    reset();
+    data_.numbers = new (memory) numbers(std::move(v));
+    type_ = json::type::array;
+    flags_ = arena ? arena_flag | packed_flag : packed_flag;
+  }
+}
+
+void value::reset_short(const char* data, std::size_t size) noexcept
+{
+  // The characters may belong to this value, for example when it is assigned one of its elements.
+  char chars[short_size];
+  std::memcpy(chars, data, size);
+  reset();
+  std::memcpy(short_data(), chars, size);
+  type_ = json::type::string;
+  flags_ = static_cast<std::uint8_t>(short_flag | size << 4);
+}
+
+void value::reset_view(const char* data, std::size_t size) noexcept
+{
+  reset();
+  data_.chars = data;
+  auto view_size = static_cast<std::uint32_t>(size);
+  std::memcpy(chars_, &view_size, sizeof(view_size));
+  type_ = json::type::string;
+  flags_ = view_flag;
+}
+
+string& value::unshort()
+{
+  auto v = text();
+  auto p = new string(v.data(), v.size());
+  data_.string = p;
+  flags_ = 0;
+  return *p;
+}
+
+template <typename T>
+void value::destroy(T* p) noexcept
+{
+  p->~T();
+  if (!(flags_ & arena_flag)) {
+    ::operator delete(p);
+  }
+}
+
+array& value::elements()
+{
+  if (flags_ & packed_flag) {
+    const auto& v = *data_.numbers;
+    array elements(v.get_allocator());
+    elements.reserve(v.size());
+    for (auto n : v) {
+      elements.emplace_back(value(n));
+    }
+    reset(std::move(elements));
+  }
+  return *data_.array;
+}
+
+const array& value::elements() const
+{
+  return (flags_ & packed_flag) ? data_.numbers->elements() : *data_.array;
+}
+
 boolean value::as_boolean() const noexcept
 {
   try {
@@ -549,7 +726,7 @@ boolean value::as_boolean() const noexcept
     case json::type::null: return false;
     case json::type::number: return data_.number != 0.0 ? true : false;
     case json::type::boolean: return data_.boolean;
-    case json::type::string: return data_.string == "true" ? true : false;
+    case json::type::string: return text() == ice::string_view("true");
     case json::type::array: return !empty();
     case json::type::object: return !empty();
     }
@@ -568,7 +745,7 @@ number value::as_number() const noexcept
     case json::type::boolean: return data_.boolean ? 1 : 0;
     case json::type::string:
     {
-      std::istringstream iss(data_.string);
+      std::istringstream iss(text().to_string());
       number v = 0;
       iss >> v;
       return v;
@@ -590,11 +767,11 @@ string value::as_string() const noexcept
     case json::type::boolean: return data_.boolean ? "true" : "false";
     case json::type::number:
     {
-      std::ostringstream oss;
-      oss << data_.number;
-      return oss.str();
+      char chars[detail::max_number_size];
+      auto end = (flags_ & integer_flag) ? detail::to_chars(chars, as_integer()) : detail::to_chars(chars, data_.number);
+      return string(chars, end);
     } break;
-    case json::type::string: return data_.string;
+    case json::type::string: return text().to_string();
     case json::type::array: return format(*this, false);
     case json::type::object: return format(*this, false);
     }
@@ -605,6 +782,29 @@ string value::as_string() const noexcept
   return std::string();
 }
 
+bool value::has_integer() const noexcept
+{
+  return type_ == json::type::number && (flags_ & integer_flag);
+}
+
+std::int64_t value::as_integer() const noexcept
+{
+  if (type_ == json::type::number && (flags_ & integer_flag)) {
+    return static_cast<std::int64_t>(to_unsigned(data_.number) + static_cast<std::uint64_t>(std::int64_t(rounding_)));
+  }
+  auto v = as_number();
+  if (v != v) {
+    return 0;
+  }
+  if (v <= -max_integer) {
+    return std::numeric_limits<std::int64_t>::min();
+  }
+  if (v >= max_integer) {
+    return std::numeric_limits<std::int64_t>::max();
+  }
+  return static_cast<std::int64_t>(v);
+}
+
 bool operator==(const value& a, const value& b)
 {
   if (a.type() != b.type()) {
@@ -613,9 +813,13 @@ bool operator==(const value& a, const value& b)
   switch (a.type()) {
   case json::type::null: return true;
   case json::type::boolean: return a.data<boolean>() == b.data<boolean>();
-  case json::type::number: return a.data<number>() == b.data<number>();
-  case json::type::string: return a.data<string>() == b.data<string>();
-  case json::type::array: return a.data<array>() == b.data<array>();
+  case json::type::number: return a.data<number>() == b.data<number>() && rounding(a) == rounding(b);
+  case json::type::string: return a.as<ice::string_view>() == b.as<ice::string_view>();
+  case json::type::array:
+    if (a.is<numbers>() && b.is<numbers>()) {
+      return a.data<numbers>() == b.data<numbers>();
+    }
+    return a.data<array>() == b.data<array>();
   case json::type::object: return a.data<object>() == b.data<object>();
   }
   return false;
@@ -633,9 +837,17 @@ bool operator<(const value& a, const value& b)
   switch (a.type()) {
   case json::type::null: return false;
   case json::type::boolean: return a.data<boolean>() < b.data<boolean>();
-  case json::type::number: return a.data<number>() < b.data<number>();
-  case json::type::string: return a.data<string>() < b.data<string>();
-  case json::type::array: return a.data<array>() < b.data<array>();
+  case json::type::number:
+    if (a.data<number>() == b.data<number>()) {
+      return rounding(a) < rounding(b);
+    }
+    return a.data<number>() < b.data<number>();
+  case json::type::string: return a.as<ice::string_view>() < b.as<ice::string_view>();
+  case json::type::array:
+    if (a.is<numbers>() && b.is<numbers>()) {
+      return a.data<numbers>() < b.data<numbers>();
+    }
+    return a.data<array>() < b.data<array>();
   case json::type::object: return a.data<object>() < b.data<object>();
   }
   return false;
@@ -649,9 +861,17 @@ bool operator>(const value& a, const value& b)
   switch (a.type()) {
   case json::type::null: return false;
   case json::type::boolean: return a.data<boolean>() > b.data<boolean>();
-  case json::type::number: return a.data<number>() > b.data<number>();
-  case json::type::string: return a.data<string>() > b.data<string>();
-  case json::type::array: return a.data<array>() > b.data<array>();
+  case json::type::number:
+    if (a.data<number>() == b.data<number>()) {
+      return rounding(a) > rounding(b);
+    }
+    return a.data<number>() > b.data<number>();
+  case json::type::string: return a.as<ice::string_view>() > b.as<ice::string_view>();
+  case json::type::array:
+    if (a.is<numbers>() && b.is<numbers>()) {
+      return a.data<numbers>() > b.data<numbers>();
+    }
+    return a.data<array>() > b.data<array>();
   case json::type::object: return a.data<object>() > b.data<object>();
   }
   return false;
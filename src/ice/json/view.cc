@@ -0,0 +1,365 @@
+#include <ice/json/view.h>
+#include <ice/json/builder.h>
+#include <ice/json/reader.h>
+#include <sstream>
+#include <cstring>
+
+namespace ice {
+namespace json {
+namespace {
+
+// Stores the decoded string of a string value.
+struct string_reader : detail::skipper {
+  string value;
+
+  bool on_string(ice::string_view v)
+  {
+    value.assign(v.data(), v.size());
+    return true;
+  }
+};
+
+// Decodes the string that starts at the given quote.
+string read_string(const char* origin, const char* it, const char* end)
+{
+  string_reader handler;
+  detail::reader<string_reader> reader(origin, it, static_cast<std::size_t>(end - it), handler);
+  reader.parse();
+  return std::move(handler.value);
+}
+
+}  // namespace
+
+view::view(const char* data, std::size_t size) : begin_(data), it_(data), end_(data + size)
+{
+  if (!data) {
+    it_ = nullptr;
+    return;
+  }
+  if (size >= 3 && data[0] == '\xEF' && data[1] == '\xBB' && data[2] == '\xBF') {
+    it_ += 3;
+  }
+  it_ = detail::skip_space(it_, end_);
+}
+
+view::view(const std::string& text) : view(text.data(), text.size())
+{}
+
+view::operator bool() const noexcept
+{
+  return it_ != nullptr;
+}
+
+json::type view::type() const
+{
+  if (!it_ || it_ == end_) {
+    throw error("incomplete input", it_);
+  }
+  switch (*it_) {
+  case 'n': return json::type::null;
+  case 't':
+  case 'f': return json::type::boolean;
+  case '"': return json::type::string;
+  case '[': return json::type::array;
+  case '{': return json::type::object;
+  case '-':
+  case '.':
+  case '0':
+  case '1':
+  case '2':
+  case '3':
+  case '4':
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9': return json::type::number;
+  }
+  throw error("syntax error", it_);
+}
+
+ice::string_view view::raw() const
+{
+  type();
+  return { it_, static_cast<std::size_t>(skip(it_) - it_) };
+}
+
+value view::get() const
+{
+  auto type = this->type();
+  value root;
+  detail::builder handler(root);
+  auto size = static_cast<std::size_t>(end_ - it_);
+  detail::reader<detail::builder> reader(begin_, it_, size, handler);
+  // The index is created in chunks while the subtree is read, so the rest of the buffer is not indexed.
+  auto nested = type == json::type::array || type == json::type::object;
+  if (nested && size >= detail::index_threshold && detail::structural_index::supported(size)) {
+    detail::structural_index index(it_, size);
+    reader.parse(index);
+  } else {
+    reader.parse();
+  }
+  return root;
+}
+
+std::size_t view::size() const
+{
+  switch (type()) {
+  case json::type::array:
+  case json::type::object: return static_cast<std::size_t>(std::distance(begin(), end()));
+  default: return 0;
+  }
+}
+
+view view::operator[](std::size_t index) const
+{
+  auto type = this->type();
+  if (type != json::type::array) {
+    throw type_error::const_access(type, index);
+  }
+  auto it = begin();
+  for (std::size_t i = 0; i < index && it != end(); i++) {
+    ++it;
+  }
+  if (it == end()) {
+    throw range_error::const_access(index);
+  }
+  return *it;
+}
+
+view view::operator[](ice::string_view key) const
+{
+  auto type = this->type();
+  if (type != json::type::object) {
+    throw type_error::const_access(type, key.to_string());
+  }
+  auto v = lookup(key);
+  if (!v) {
+    throw range_error::const_access(key.to_string());
+  }
+  return v;
+}
+
+view view::find(ice::string_view key) const
+{
+  if (!it_ || type() != json::type::object) {
+    return {};
+  }
+  return lookup(key);
+}
+
+bool view::contains(ice::string_view key) const
+{
+  return static_cast<bool>(find(key));
+}
+
+boolean view::as_boolean() const
+{
+  switch (type()) {
+  case json::type::array:
+  case json::type::object: return begin() != end();
+  default: return get().as_boolean();
+  }
+}
+
+number view::as_number() const
+{
+  switch (type()) {
+  case json::type::array:
+  case json::type::object: return static_cast<number>(size());
+  default: return get().as_number();
+  }
+}
+
+std::int64_t view::as_integer() const
+{
+  switch (type()) {
+  case json::type::array:
+  case json::type::object: return static_cast<std::int64_t>(size());
+  default: return get().as_integer();
+  }
+}
+
+string view::as_string() const
+{
+  if (type() == json::type::string) {
+    return read_string(begin_, it_, end_);
+  }
+  return raw().to_string();
+}
+
+view::iterator view::begin() const
+{
+  switch (type()) {
+  case json::type::array:
+  case json::type::object: return { *this, it_ + 1 };
+  default: return {};
+  }
+}
+
+view::iterator view::end() const noexcept
+{
+  return {};
+}
+
+// Returns the end of the value that starts at the given position.
+// Arrays and objects are skipped by matching brackets outside of strings and comments.
+const char* view::skip(const char* it) const
+{
+  if (*it == '[' || *it == '{') {
+    std::size_t depth = 0;
+    while (it != end_) {
+      if (!detail::is_char(*it, detail::char_nested)) {
+        ++it;
+        continue;
+      }
+      switch (*it) {
+      case '"':
+        it = detail::skip_string(it, end_);
+        if (!it) {
+          throw error("incomplete input", end_);
+        }
+        continue;
+      case '/':
+        if (end_ - it < 2 || it[1] != '/') {
+          throw error("syntax error", it);
+        }
+        it = static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(end_ - it)));
+        if (!it) {
+          throw error("incomplete input", end_);
+        }
+        break;
+      case '[':
+      case '{': depth++; break;
+      case ']':
+      case '}':
+        if (--depth == 0) {
+          return it + 1;
+        }
+        break;
+      }
+      ++it;
+    }
+    throw error("incomplete input", it);
+  }
+  detail::skipper handler;
+  detail::reader<detail::skipper> reader(begin_, it, static_cast<std::size_t>(end_ - it), handler);
+  reader.parse();
+  return reader.position();
+}
+
+// Scans all object elements, so that the last duplicate key wins.
+view view::lookup(ice::string_view key) const
+{
+  view match;
+  for (auto it = begin(); it != end(); ++it) {
+    auto open = it.name_;
+    auto close = detail::skip_string(open, end_) - 1;
+    if (std::memchr(open, '\\', static_cast<std::size_t>(close - open))) {
+      if (ice::string_view(read_string(begin_, open, end_)) == key) {
+        match = *it;
+      }
+    } else if (ice::string_view(open + 1, static_cast<std::size_t>(close - open - 1)) == key) {
+      match = *it;
+    }
+  }
+  return match;
+}
+
+// Creates a parse error with the line and column of the given position in the buffer.
+parse_error view::error(const char* message, const char* it) const
+{
+  std::size_t line = 1;
+  std::size_t column = 0;
+  for (auto pos = begin_; pos && pos != it && pos != end_; ++pos) {
+    if (*pos == '\n') {
+      line++;
+      column = 0;
+    }
+    column++;
+  }
+  std::ostringstream oss;
+  oss << message << " (line " << line << " column " << column + 1;
+  if (it && it != end_) {
+    auto c = *it;
+    if (c >= ' ' && c <= '~') {
+      oss << " '" << c << "'";
+    } else {
+      oss << " '" << (static_cast<unsigned int>(c) & 0xFF) << "'";
+    }
+  }
+  oss << ")";
+  return oss.str();
+}
+
+view::iterator::iterator(const view& container, const char* it) :
+  value_(container.begin_, it, container.end_), close_(*container.it_ == '[' ? ']' : '}')
+{
+  read();
+}
+
+string view::iterator::name() const
+{
+  if (!name_) {
+    return {};
+  }
+  return read_string(value_.begin_, name_, value_.end_);
+}
+
+view::iterator& view::iterator::operator++()
+{
+  auto it = detail::skip_space(value_.skip(value_.it_), value_.end_);
+  if (it == value_.end_) {
+    throw value_.error("incomplete input", it);
+  }
+  if (*it == close_) {
+    value_.it_ = nullptr;
+    name_ = nullptr;
+    return *this;
+  }
+  if (*it != ',') {
+    throw value_.error(close_ == ']' ? "invalid array syntax" : "invalid object syntax", it);
+  }
+  value_.it_ = it + 1;
+  read();
+  return *this;
+}
+
+// Moves from the position after '[', '{' or ',' to the next element value or to the end of the container.
+void view::iterator::read()
+{
+  auto it = value_.it_;
+  auto end = value_.end_;
+  it = detail::skip_space(it, end);
+  if (it == end) {
+    throw value_.error("incomplete input", it);
+  }
+  if (*it == close_) {
+    value_.it_ = nullptr;
+    name_ = nullptr;
+    return;
+  }
+  if (close_ == '}') {
+    if (*it != '"') {
+      throw value_.error("invalid object syntax", it);
+    }
+    name_ = it;
+    it = detail::skip_string(it, end);
+    if (!it) {
+      throw value_.error("incomplete input", end);
+    }
+    it = detail::skip_space(it, end);
+    if (it == end) {
+      throw value_.error("incomplete input", it);
+    }
+    if (*it != ':') {
+      throw value_.error("invalid object syntax", it);
+    }
+    ++it;
+    it = detail::skip_space(it, end);
+  }
+  value_.it_ = it;
+}
+
+}  // namespace json
+}  // namespace ice
@@ -0,0 +1,190 @@
+#include <ice/json/writer.h>
+#include <ice/json/format.h>
+#include <ice/json/number.h>
+#include <ice/json/output.h>
+#include <stdexcept>
+
+namespace ice {
+namespace json {
+
+writer::writer(buffer& out, bool pretty) : out_(out), pretty_(pretty)
+{}
+
+writer::writer(std::ostream& os, bool pretty) :
+  own_(data_, sizeof(data_), [&os](const char* s, std::size_t size) {
+    os.write(s, static_cast<std::streamsize>(size));
+  }),
+  out_(own_), pretty_(pretty)
+{}
+
+writer::writer(zlib::deflate& deflate, zlib::handler handler, bool pretty) :
+  own_(data_, sizeof(data_), [&deflate, handler](const char* s, std::size_t size) {
+    deflate.process(s, size, false, handler);
+  }),
+  out_(own_), pretty_(pretty)
+{}
+
+writer& writer::begin_array()
+{
+  next();
+  out_.append('[');
+  stack_.push_back('[');
+  first_ = true;
+  return *this;
+}
+
+writer& writer::end_array()
+{
+  close(']');
+  return *this;
+}
+
+writer& writer::begin_object()
+{
+  next();
+  out_.append('{');
+  stack_.push_back('{');
+  first_ = true;
+  return *this;
+}
+
+writer& writer::end_object()
+{
+  close('}');
+  return *this;
+}
+
+writer& writer::key(ice::string_view name)
+{
+  if (stack_.empty() || stack_.back() != '{') {
+    throw std::logic_error("json writer: key outside of an object");
+  }
+  if (key_) {
+    throw std::logic_error("json writer: missing object value");
+  }
+  if (!first_) {
+    out_.append(',');
+  }
+  if (pretty_) {
+    detail::indent(out_, stack_.size() * 2);
+  }
+  out_.append('"');
+  detail::escape(out_, name.data(), name.size());
+  if (pretty_) {
+    out_.append("\": ", 3);
+  } else {
+    out_.append("\":", 2);
+  }
+  first_ = false;
+  key_ = true;
+  return *this;
+}
+
+writer& writer::value(json::null)
+{
+  next();
+  out_.append("null", 4);
+  return *this;
+}
+
+writer& writer::value(json::boolean v)
+{
+  next();
+  if (v) {
+    out_.append("true", 4);
+  } else {
+    out_.append("false", 5);
+  }
+  return *this;
+}
+
+writer& writer::value(json::number v)
+{
+  next();
+  char chars[detail::max_number_size];
+  auto end = detail::to_chars(chars, v);
+  out_.append(chars, static_cast<std::size_t>(end - chars));
+  return *this;
+}
+
+writer& writer::value(std::int64_t v)
+{
+  next();
+  char chars[detail::max_number_size];
+  auto end = detail::to_chars(chars, v);
+  out_.append(chars, static_cast<std::size_t>(end - chars));
+  return *this;
+}
+
+writer& writer::value(ice::string_view v)
+{
+  next();
+  out_.append('"');
+  detail::escape(out_, v.data(), v.size());
+  out_.append('"');
+  return *this;
+}
+
+writer& writer::value(const char* v)
+{
+  return value(ice::string_view(v));
+}
+
+writer& writer::value(const json::value& v)
+{
+  next();
+  format(out_, v, pretty_, stack_.size() * 2);
+  return *this;
+}
+
+void writer::flush()
+{
+  out_.flush();
+}
+
+// Checks that a value can be written at the current position and writes the separator for array elements.
+void writer::next()
+{
+  if (stack_.empty()) {
+    if (root_) {
+      throw std::logic_error("json writer: root value already written");
+    }
+    root_ = true;
+    return;
+  }
+  if (stack_.back() == '{') {
+    if (!key_) {
+      throw std::logic_error("json writer: missing object key");
+    }
+    key_ = false;
+    return;
+  }
+  if (!first_) {
+    out_.append(',');
+  }
+  if (pretty_) {
+    detail::indent(out_, stack_.size() * 2);
+  }
+  first_ = false;
+}
+
+// Writes the closing character of the current array or object.
+void writer::close(char c)
+{
+  if (stack_.empty() || stack_.back() != (c == ']' ? '[' : '{')) {
+    throw std::logic_error(c == ']' ? "json writer: end_array() without an array" :
+                                      "json writer: end_object() without an object");
+  }
+  if (key_) {
+    throw std::logic_error("json writer: missing object value");
+  }
+  stack_.pop_back();
+  if (pretty_ && !first_) {
+    detail::indent(out_, stack_.size() * 2);
+  }
+  out_.append(c);
+  first_ = false;
+}
+
+}  // namespace json
+}  // namespace ice